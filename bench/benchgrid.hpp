@@ -0,0 +1,116 @@
+#ifndef HC_BENCHGRID_H
+#define HC_BENCHGRID_H
+
+// Plain in-memory grid on which the Cell kernels can be run without
+// MPI or LibGeoDecomp simulators, through a minimal neighborhood
+// object providing the FixedCoord access they are templated on. Used
+// by the kernel microbenchmark and the reference comparison harness.
+
+#include <utility>
+#include <vector>
+
+#include <cell.hpp>
+
+
+// Grid of cells stored row by row with a one cell halo on all sides,
+// so neighbours of any interior cell are always in bounds
+class BenchGrid
+{
+public:
+    BenchGrid(int nx, int ny) :
+	nx(nx),
+	ny(ny),
+	stride(nx + 2),
+	cells((nx + 2) * (ny + 2))
+    {}
+
+    Cell& operator()(int x, int y)
+    {
+	return cells[(y + 1) * stride + (x + 1)];
+    }
+
+    int nx;
+    int ny;
+    int stride;
+    std::vector<Cell> cells;
+};
+
+
+class BenchNeighborhood
+{
+public:
+    BenchNeighborhood(const Cell *cell, int stride) :
+	cell(cell),
+	stride(stride)
+    {}
+
+    template<int X, int Y, int Z>
+    const Cell& operator[](LibGeoDecomp::FixedCoord<X, Y, Z>) const
+    {
+	return cell[Y * stride + X];
+    }
+
+private:
+    const Cell *cell;
+    int stride;
+};
+
+
+// Resets all cells (including the halo) and sets cell types (edge,
+// corner, etc.) as Cell::grid does
+inline void setCellTypes(BenchGrid& grid)
+{
+    for (Cell& cell : grid.cells)
+    {
+	cell = Cell();
+	cell.celltype = Cell::NODATA;
+    }
+
+    for (int y=0; y<grid.ny; y++)
+    {
+	for (int x=0; x<grid.nx; x++)
+	{
+	    Cell& cell = grid(x, y);
+	    if (y == 0)
+		cell.celltype = (x == 0) ? Cell::CORNER_SW : (x == grid.nx-1) ? Cell::CORNER_SE : Cell::EDGE_SOUTH;
+	    else if (y == grid.ny-1)
+		cell.celltype = (x == 0) ? Cell::CORNER_NW : (x == grid.nx-1) ? Cell::CORNER_NE : Cell::EDGE_NORTH;
+	    else
+		cell.celltype = (x == 0) ? Cell::EDGE_WEST : (x == grid.nx-1) ? Cell::EDGE_EAST : Cell::INTERNAL;
+	    cell.celltype_double = static_cast<double>(cell.celltype);
+	}
+    }
+}
+
+
+// Applies kernel to every cell of the grid, reading from oldGrid and
+// writing to newGrid, as LibGeoDecomp does for one nanostep
+template<typename KERNEL>
+void sweep(BenchGrid& oldGrid, BenchGrid& newGrid, KERNEL kernel)
+{
+    for (int y=0; y<oldGrid.ny; y++)
+    {
+	for (int x=0; x<oldGrid.nx; x++)
+	{
+	    BenchNeighborhood neighborhood(&oldGrid(x, y), oldGrid.stride);
+	    kernel(newGrid(x, y), neighborhood);
+	}
+    }
+}
+
+
+// One full timestep (all nanosteps), swapping grids in between so
+// that the result is always in grid
+inline void updateTimestep(BenchGrid& grid, BenchGrid& scratch)
+{
+    for (unsigned nanoStep=0; nanoStep<4; nanoStep++)
+    {
+	sweep(grid, scratch, [nanoStep](Cell& cell, const BenchNeighborhood& neighborhood)
+	      {
+		  cell.update(neighborhood, nanoStep);
+	      });
+	std::swap(grid.cells, scratch.cells);
+    }
+}
+
+#endif
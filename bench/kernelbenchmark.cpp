@@ -0,0 +1,174 @@
+// Microbenchmark of the Cell kernels, without MPI or LibGeoDecomp
+// simulators: the kernels are run over a plain in-memory grid through
+// a minimal neighborhood object providing the FixedCoord access they
+// are templated on.
+//
+// Usage: bench [nx,ny,...] [wet_fraction,...] [repetitions]
+//   e.g. bin/bench 256,1024,4096 0,0.1,0.5,1 5
+//
+// Times are reported per cell update (ns/cell, for "update" per cell
+// and full timestep of all nanosteps) together with the effective
+// memory bandwidth assuming each nanostep reads one Cell and writes
+// one Cell (GB/s).
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "benchgrid.hpp"
+
+
+// Sloping plane with random roughness, of which the given fraction of
+// cells holds water
+void initialiseGrid(BenchGrid& grid, double wetFraction)
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    setCellTypes(grid);
+    for (int y=0; y<grid.ny; y++)
+    {
+	for (int x=0; x<grid.nx; x++)
+	{
+	    Cell& cell = grid(x, y);
+	    cell.elevation = 0.01 * (x + y) + 0.05 * uniform(generator);
+	    cell.waterDepth = (uniform(generator) < wetFraction) ? 0.05 + 0.1 * uniform(generator) : 0.0;
+	    cell.waterLevel = cell.elevation + cell.waterDepth;
+	    cell.rainRate = Cell::numericalRainRate(10.0);
+	}
+    }
+}
+
+
+// Times repeated sweeps of kernel over the grid
+template<typename KERNEL>
+double timeKernel(BenchGrid& oldGrid, BenchGrid& newGrid, int repetitions, KERNEL kernel)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int r=0; r<repetitions; r++)
+    {
+	sweep(oldGrid, newGrid, kernel);
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+
+// passes is the number of times each cell is read and written
+void report(const std::string& kernel, const BenchGrid& grid, double wetFraction, double nanoseconds, double updates, int passes=1)
+{
+    double nsPerCell = nanoseconds / updates;
+    double gigabytesPerSecond = 2.0 * passes * sizeof(Cell) / nsPerCell;
+
+    std::cout << std::left << std::setw(12) << kernel
+	      << std::right << std::setw(7) << grid.nx << std::setw(7) << grid.ny
+	      << std::fixed << std::setprecision(2) << std::setw(7) << wetFraction
+	      << std::setprecision(3) << std::setw(12) << nsPerCell
+	      << std::setw(10) << gigabytesPerSecond << std::endl;
+}
+
+
+std::vector<double> parseList(const std::string& list)
+{
+    std::vector<double> values;
+    std::stringstream stream(list);
+    std::string value;
+    while (std::getline(stream, value, ','))
+    {
+	values.push_back(atof(value.c_str()));
+    }
+    return values;
+}
+
+
+int main(int argc, char *argv[])
+{
+    std::vector<double> sizes = { 256, 1024, 2048 };
+    std::vector<double> wetFractions = { 0.0, 0.1, 0.5, 1.0 };
+    int repetitions = 5;
+    if (argc > 1) sizes = parseList(argv[1]);
+    if (argc > 2) wetFractions = parseList(argv[2]);
+    if (argc > 3) repetitions = atoi(argv[3]);
+
+    // Parameters of test/idealised/idealised.params
+    Cell::timestep = 1.0;
+    Cell::DX = 10.0;
+    Cell::DY = 10.0;
+    Cell::no_data_value = -9999.0;
+    Cell::edgeslope = 0.001;
+    Cell::hflowThreshold = 0.001;
+    Cell::courantNumber = 0.7;
+    Cell::mannings = 0.04;
+    Cell::froudeLimit = 0.8;
+    Cell::waterDepthErosionThreshold = 0.01;
+    Cell::rain_in_high_places = true;
+    Cell::rain_above_elevation = 0.0;
+
+    std::cout << "sizeof(Cell) = " << sizeof(Cell) << " bytes, " << repetitions << " repetitions" << std::endl;
+    std::cout << std::left << std::setw(12) << "kernel"
+	      << std::right << std::setw(7) << "nx" << std::setw(7) << "ny" << std::setw(7) << "wet"
+	      << std::setw(12) << "ns/cell" << std::setw(10) << "GB/s" << std::endl;
+
+    for (double size : sizes)
+    {
+	for (double wetFraction : wetFractions)
+	{
+	    BenchGrid oldGrid(size, size);
+	    BenchGrid newGrid(size, size);
+	    initialiseGrid(oldGrid, wetFraction);
+	    newGrid.cells = oldGrid.cells;
+	    double updates = static_cast<double>(oldGrid.nx) * oldGrid.ny * repetitions;
+
+	    report("flowRouteX", oldGrid, wetFraction,
+		   timeKernel(oldGrid, newGrid, repetitions, [](Cell& cell, const BenchNeighborhood& neighborhood)
+			      {
+				  cell = here;
+				  cell.flowRouteX(neighborhood);
+			      }), updates);
+
+	    report("flowRouteY", oldGrid, wetFraction,
+		   timeKernel(oldGrid, newGrid, repetitions, [](Cell& cell, const BenchNeighborhood& neighborhood)
+			      {
+				  cell = here;
+				  cell.flowRouteY(neighborhood);
+			      }), updates);
+
+	    report("updateQ", oldGrid, wetFraction,
+		   timeKernel(oldGrid, newGrid, repetitions, [](Cell& cell, const BenchNeighborhood& neighborhood)
+			      {
+				  cell = here;
+				  cell.updateQ(here.qX, cell.qX, here.waterDepth + 0.01, 0.001, Cell::timestep);
+			      }), updates);
+
+	    report("depthUpdate", oldGrid, wetFraction,
+		   timeKernel(oldGrid, newGrid, repetitions, [](Cell& cell, const BenchNeighborhood& neighborhood)
+			      {
+				  cell = here;
+				  cell.depthUpdate(neighborhood);
+			      }), updates);
+
+	    // Full update cycle: all nanosteps, swapping grids in between
+	    double nanoseconds = 0.0;
+	    for (int r=0; r<repetitions; r++)
+	    {
+		for (unsigned nanoStep=0; nanoStep<4; nanoStep++)
+		{
+		    nanoseconds += timeKernel(oldGrid, newGrid, 1, [nanoStep](Cell& cell, const BenchNeighborhood& neighborhood)
+					      {
+						  cell.update(neighborhood, nanoStep);
+					      });
+		    std::swap(oldGrid.cells, newGrid.cells);
+		}
+	    }
+	    report("update", oldGrid, wetFraction, nanoseconds, updates, 4);
+	}
+    }
+
+    return 0;
+}
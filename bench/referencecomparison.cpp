@@ -0,0 +1,268 @@
+// Reference comparison harness: runs the Cell kernels of the parallel
+// port and the serial LSDCatchmentModel (HAIL-CAESAR) reference side
+// by side on the same DEM and initial water, and compares water depth
+// and discharges at chosen steps within tolerances. The time spent
+// stepping each engine is reported too.
+//
+// Usage: compare <param path> <param file> <steps> <compare interval> <initial water depth (m)>
+//                [max timestep (s)] [depth tolerance (m)] [discharge tolerance (m2/s)] [edge margin (cells)]
+//                [wet below elevation (m)] [relative volume tolerance] [port friction exponent]
+//   e.g. bin/compare test/reference reference.params 1000 250 0.02 1.0 1e-5 1e-5 0 1.02 1e-9 3
+//   (from the repository root; see test/reference/reference.params)
+//
+// The parameter file is a LSDCatchmentModel parameter file. The DEM
+// it names (ASCII raster, NODATA cells take no part in either) and its hydraulic
+// parameters (DX, edgeslope, hflow_threshold, courant_number,
+// mannings_n, froude_num_limit, water_depth_erosion_threshold) are
+// used for both engines. There is no rainfall or other water input:
+// both engines start from the same uniform water depth over the DEM
+// (or over the cells below the given elevation only) and are advanced with the same timestep each step, being the max
+// timestep limited by the reference's CFL condition, so that any
+// difference comes from the hydraulics (flow routing, depth update and
+// water flux out of the edges) alone.
+//
+// Reference cell [x][y] (1-based, with border) corresponds to port
+// cell (x-1, y-1), so that reference x-1 is west and y-1 is south, and
+// qx[x][y] / qy[x][y] are the discharges across the same faces as qX
+// and qY. Known differences between the two (e.g. the integer
+// exponent 10/3, so 3, in the reference's friction term, and its
+// treatment of the domain edges) show up as differences concentrated
+// where they apply, hence the location of the largest difference is
+// reported, the port can be given the reference's friction exponent,
+// and the given number of cells along the domain edges can be left
+// out of the comparison. Wetting only the bottom of a basin keeps the
+// water away from the edges, so that the two engines can be held to
+// tight tolerances, including on the water volume, which neither may
+// then change.
+//
+// Exits with failure if any compared field exceeds its tolerance.
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <LSDCatchmentModel.hpp>
+
+#include "benchgrid.hpp"
+
+
+struct FieldDifference
+{
+    double maxDifference = 0.0;
+    double rmsDifference = 0.0;
+    int maxX = 0;
+    int maxY = 0;
+};
+
+
+// Difference between reference field and port cell member over the
+// domain without margin cells along its edges
+FieldDifference compareField(LSDGrid<double>& reference, BenchGrid& grid, double Cell::*member, int margin)
+{
+    FieldDifference difference;
+    double sumSquares = 0.0;
+    double cells = 0.0;
+    for (int y=margin; y<grid.ny-margin; y++)
+    {
+	for (int x=margin; x<grid.nx-margin; x++)
+	{
+	    cells++;
+	    double delta = std::abs(reference[x + 1][y + 1] - grid(x, y).*member);
+	    sumSquares += delta * delta;
+	    if (delta > difference.maxDifference)
+	    {
+		difference.maxDifference = delta;
+		difference.maxX = x;
+		difference.maxY = y;
+	    }
+	}
+    }
+    difference.rmsDifference = (cells > 0) ? std::sqrt(sumSquares / cells) : 0.0;
+    return difference;
+}
+
+
+// Prints one line of comparison, returns whether within tolerance
+bool report(const std::string& field, const FieldDifference& difference, double tolerance)
+{
+    bool pass = difference.maxDifference <= tolerance;
+    std::cout << "    " << std::left << std::setw(12) << field << std::right
+	      << " max " << std::scientific << std::setprecision(3) << difference.maxDifference
+	      << " at (" << difference.maxX << "," << difference.maxY << ")"
+	      << "  rms " << difference.rmsDifference
+	      << "  tolerance " << tolerance
+	      << (pass ? "  ok" : "  FAIL") << std::endl;
+    return pass;
+}
+
+
+double waterVolume(LSDGrid<double>& waterDepth, int imax, int jmax, double DX)
+{
+    double volume = 0.0;
+    for (int x=1; x<=imax; x++)
+    {
+	for (int y=1; y<=jmax; y++)
+	{
+	    volume += waterDepth[x][y];
+	}
+    }
+    return volume * DX * DX;
+}
+
+
+double waterVolume(BenchGrid& grid)
+{
+    double volume = 0.0;
+    for (int y=0; y<grid.ny; y++)
+    {
+	for (int x=0; x<grid.nx; x++)
+	{
+	    volume += grid(x, y).waterDepth;
+	}
+    }
+    return volume * Cell::DX * Cell::DY;
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc < 6)
+    {
+	std::cout << "Usage: " << argv[0] << " <param path> <param file> <steps> <compare interval> <initial water depth (m)>"
+		  << " [max timestep (s)] [depth tolerance (m)] [discharge tolerance (m2/s)] [edge margin (cells)]"
+		  << " [wet below elevation (m)] [relative volume tolerance] [port friction exponent]" << std::endl;
+	return EXIT_FAILURE;
+    }
+    const int steps = atoi(argv[3]);
+    const int compareInterval = std::max(1, atoi(argv[4]));
+    const double initialWaterDepth = atof(argv[5]);
+    const double maxTimestep = (argc > 6) ? atof(argv[6]) : 1.0;
+    const double depthTolerance = (argc > 7) ? atof(argv[7]) : 1.0e-3;
+    const double dischargeTolerance = (argc > 8) ? atof(argv[8]) : 1.0e-3;
+    const int margin = (argc > 9) ? atoi(argv[9]) : 0;
+    const double wetBelow = (argc > 10) ? atof(argv[10]) : HUGE_VAL;
+    const double volumeTolerance = (argc > 11) ? atof(argv[11]) : HUGE_VAL;
+    const double frictionExponent = (argc > 12) ? atof(argv[12]) : 10.0 / 3.0;
+
+    // Reference (which concatenates parameter path and file name)
+    std::string paramPath = argv[1];
+    if (paramPath.back() != '/') paramPath += "/";
+    LSDCatchmentModel reference(paramPath, argv[2]);
+    reference.initialise_model_domain_extents();
+    reference.initialise_arrays();
+    reference.load_data();
+
+    const int imax = reference.get_imax();
+    const int jmax = reference.get_jmax();
+    LSDGrid<double>& elev = reference.get_elev();
+    LSDGrid<double>& waterDepth = reference.get_water_depth();
+
+    // Port, with the reference's parameters
+    Cell::DX = reference.get_DX();
+    Cell::DY = reference.get_DX();
+    Cell::no_data_value = reference.get_no_data_value();
+    Cell::edgeslope = reference.get_edgeslope();
+    Cell::hflowThreshold = reference.get_hflow_threshold();
+    Cell::courantNumber = reference.get_courant_number();
+    Cell::mannings = reference.get_mannings();
+    Cell::froudeLimit = reference.get_froude_limit();
+    Cell::frictionExponent = frictionExponent;
+    Cell::waterDepthErosionThreshold = reference.get_water_depth_erosion_threshold();
+    Cell::rain_in_high_places = false;
+
+    BenchGrid grid(imax, jmax);
+    BenchGrid scratch(imax, jmax);
+    setCellTypes(grid);
+
+    for (int x=1; x<=imax; x++)
+    {
+	for (int y=1; y<=jmax; y++)
+	{
+	    Cell& cell = grid(x - 1, y - 1);
+	    cell.elevation = elev[x][y];
+	    if (elev[x][y] == reference.get_no_data_value())
+	    {
+		cell.celltype = Cell::NODATA;
+		cell.celltype_double = static_cast<double>(Cell::NODATA);
+		continue;
+	    }
+	    if (elev[x][y] >= wetBelow)
+	    {
+		cell.waterLevel = cell.elevation;
+		continue;
+	    }
+	    waterDepth[x][y] = initialWaterDepth;
+
+	    cell.waterDepth = initialWaterDepth;
+	    cell.waterLevel = cell.elevation + cell.waterDepth;
+	}
+    }
+    scratch.cells = grid.cells;
+
+    std::cout << "\nComparing on " << imax << " x " << jmax << " cells for " << steps << " steps,"
+	      << " initial water depth " << initialWaterDepth << " m, max timestep " << maxTimestep << " s,"
+	      << " ignoring " << margin << " cells along the edges" << std::endl;
+
+    double referenceSeconds = 0.0;
+    double portSeconds = 0.0;
+    double time = 0.0;
+    bool pass = true;
+    for (int step=1; step<=steps; step++)
+    {
+	// Reference hydraulics, as in its hydro-only update cycle
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	reference.set_time_factor(maxTimestep);
+	double timestep = reference.set_local_timefactor();
+	reference.check_wetted_area(1);
+	reference.flow_route();
+	reference.depth_update();
+	reference.water_flux_out();
+	reference.increment_counters();
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	referenceSeconds += std::chrono::duration<double>(end - start).count();
+
+	// Port, with the same timestep
+	start = std::chrono::steady_clock::now();
+	Cell::timestep = timestep;
+	updateTimestep(grid, scratch);
+	end = std::chrono::steady_clock::now();
+	portSeconds += std::chrono::duration<double>(end - start).count();
+
+	time += timestep;
+	if (step % compareInterval == 0 || step == steps)
+	{
+	    double referenceVolume = waterVolume(waterDepth, imax, jmax, reference.get_DX());
+	    double portVolume = waterVolume(grid);
+	    double volumeDifference = std::abs(portVolume - referenceVolume) / referenceVolume;
+	    bool volumePass = volumeDifference <= volumeTolerance;
+	    pass &= volumePass;
+	    std::cout << "  step " << step << ", time " << std::fixed << std::setprecision(2) << time << " s,"
+		      << " water volume reference " << referenceVolume
+		      << " m3, port " << portVolume << " m3";
+	    if (volumeTolerance < HUGE_VAL)
+	    {
+		std::cout << std::scientific << std::setprecision(3) << ", relative difference " << volumeDifference
+			  << "  tolerance " << volumeTolerance << (volumePass ? "  ok" : "  FAIL");
+	    }
+	    std::cout << std::endl;
+	    pass &= report("waterDepth", compareField(waterDepth, grid, &Cell::waterDepth, margin), depthTolerance);
+	    pass &= report("qX", compareField(reference.get_qx(), grid, &Cell::qX, margin), dischargeTolerance);
+	    pass &= report("qY", compareField(reference.get_qy(), grid, &Cell::qY, margin), dischargeTolerance);
+	}
+    }
+
+    double cellUpdates = static_cast<double>(imax) * jmax * steps;
+    std::cout << std::fixed << std::setprecision(3)
+	      << "\nTiming (" << steps << " steps):" << std::endl
+	      << "  reference " << referenceSeconds << " s, " << std::setprecision(1) << 1.0e9 * referenceSeconds / cellUpdates << " ns/cell" << std::endl
+	      << std::setprecision(3)
+	      << "  port      " << portSeconds << " s, " << std::setprecision(1) << 1.0e9 * portSeconds / cellUpdates << " ns/cell" << std::endl
+	      << std::setprecision(2)
+	      << "  speedup   " << referenceSeconds / portSeconds << std::endl;
+
+    std::cout << "\n" << (pass ? "PASS" : "FAIL") << ": fields " << (pass ? "within" : "exceed") << " tolerances" << std::endl;
+    return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
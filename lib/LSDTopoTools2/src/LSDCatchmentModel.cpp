@@ -50,14 +50,17 @@
 #include <cmath>
 #include <vector>
 #include <algorithm>
+#include <functional>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <iterator> // For the printing vector method
 #include <sys/stat.h> // For errors
 #include <cstdio> // Only for the debug macro
+#include <climits>
 
 #include "LSDCatchmentModel.hpp"
+#include "LSDIndexRaster.hpp"
 
 // DV - One day, I'd like to integrate this more into the LSDTopoTools,
 // particulalrly the LSDBasin object using it to 'cut out' basins,
@@ -209,6 +212,22 @@ void LSDCatchmentModel::initialise_model_domain_extents()
                  without a valid DEM to read from" << std::endl;
                  exit(EXIT_FAILURE);
   }
+
+  // flt and bil DEMs keep their georeferencing in a separate .hdr file
+  if (dem_read_extension == "flt" || dem_read_extension == "bil")
+  {
+    std::cout << "\n\nLoading DEM header info, the filename is " << FILENAME << std::endl;
+    LSDBinaryRasterHeader header = read_binary_raster_header(read_path + "/" + read_fname, dem_read_extension);
+    jmax = header.NCols;
+    imax = header.NRows;
+    xll = header.XMinimum;
+    yll = header.YMinimum;
+    DX = header.DataResolution;
+    no_data_value = header.NoDataValue;
+    std::cout << "The model domain has been set from reading the elevation DEM header." << std::endl;
+    return;
+  }
+
   try
   {
     std::cout << "\n\nLoading DEM header info, the filename is " << FILENAME << std::endl;
@@ -263,33 +282,60 @@ void LSDCatchmentModel::load_data()
   // object, 'elevR'
   try
   {
-    elevR.read_ascii_raster(DEM_FILENAME);
-    // You have now read in all the headers and the raster data
-    // Headers are accessed by elevR.get_Ncols(), elevR.get_NRows() etc
-    // Raster is accessed by elevR.get_RasterData_dbl() (type: TNT::Array2D<double>)
-
-    // Load the raw ascii raster data
-    TNT::Array2D<double> raw_elev = elevR.get_RasterData_dbl();
-
     // We want an edge pixel of zeros surrounding the raster data
     // So start the counters at one, rather than zero, this
     // will ensure that elev[0][n] is not written to and left set to zero.
     // remember this data member is set with dim size equal to jmax + 2 to
     // allow the border of zeros
 
-    for (unsigned i=0; i<imax; i++)
+    if (dem_read_extension == "flt" || dem_read_extension == "bil")
     {
-      for (unsigned j=0; j<jmax; j++)
+      // Binary DEMs are mapped into memory and copied straight from the
+      // page cache. Huge negative values in bil files stand for no data
+      // (see LSDRaster::read_raster); only the pages holding any get a
+      // private copy when they are replaced
+      elevR.read_raster_mapped(read_path + "/" + read_fname, dem_read_extension,
+                               dem_read_extension == "bil" ? map_copy_on_write : map_read_only);
+      if (dem_read_extension == "bil")
       {
-        elev[i+1][j+1] = raw_elev[i][j];
+        elevR.mask_to_nodata_below_threshold(-1e10);
+      }
+
+      for (unsigned i=0; i<imax; i++)
+      {
+        for (unsigned j=0; j<jmax; j++)
+        {
+          elev[i+1][j+1] = elevR.get_data_element(i, j);
+        }
+      }
+    }
+    else
+    {
+      elevR.read_ascii_raster(DEM_FILENAME);
+      // You have now read in all the headers and the raster data
+      // Headers are accessed by elevR.get_Ncols(), elevR.get_NRows() etc
+      // Raster is accessed by elevR.get_RasterData_dbl() (type: TNT::Array2D<double>)
+
+      // Load the raw ascii raster data
+      TNT::Array2D<double> raw_elev = elevR.get_RasterData_dbl();
+
+      for (unsigned i=0; i<imax; i++)
+      {
+        for (unsigned j=0; j<jmax; j++)
+        {
+          elev[i+1][j+1] = raw_elev[i][j];
+        }
       }
     }
 
     // Check that there is an outlet for the catchment water
     check_DEM_edge_condition();
 
-    // deep copy needed? -- DAV 2/12/2015
-    init_elevs = elev;
+    // LSDGrid assignment is a deep copy
+    if (write_elevdiff_file)
+    {
+      init_elevs = elev;
+    }
 
   }
   catch(...)
@@ -313,17 +359,36 @@ void LSDCatchmentModel::load_data()
     }
     try
     {
-      hydroindexR.read_ascii_raster_integers(HYDROINDEX_FILENAME);
-      // wrong, becuase rfarea is bigger than the raster data in hydroindexR by 1 pixel around the array
-      // DAV fix 30/08/16
-      TNT::Array2D<int> raw_rfarea = hydroindexR.get_RasterData_int();
-      
-      // Solves padding issues(?)
-      for (unsigned i=0; i<imax; i++)
+      // A bil hydroindex of 32 bit integers is mapped into memory and
+      // copied straight from the page cache (other data types are read
+      // and converted); anything else is read as an ascii raster
+      size_t dot = HYDROINDEX_FILENAME.find_last_of('.');
+      if (dot != std::string::npos && HYDROINDEX_FILENAME.substr(dot+1) == "bil")
       {
-        for (unsigned j=0; j<jmax; j++)
+        LSDIndexRaster hydroindexIR;
+        hydroindexIR.read_raster_mapped(HYDROINDEX_FILENAME.substr(0, dot), "bil", map_read_only);
+        for (unsigned i=0; i<imax; i++)
         {
-          rfarea[i+1][j+1] = raw_rfarea[i][j];
+          for (unsigned j=0; j<jmax; j++)
+          {
+            rfarea[i+1][j+1] = hydroindexIR.get_data_element(i, j);
+          }
+        }
+      }
+      else
+      {
+        hydroindexR.read_ascii_raster_integers(HYDROINDEX_FILENAME);
+        // wrong, becuase rfarea is bigger than the raster data in hydroindexR by 1 pixel around the array
+        // DAV fix 30/08/16
+        TNT::Array2D<int> raw_rfarea = hydroindexR.get_RasterData_int();
+
+        // Solves padding issues(?)
+        for (unsigned i=0; i<imax; i++)
+        {
+          for (unsigned j=0; j<jmax; j++)
+          {
+            rfarea[i+1][j+1] = raw_rfarea[i][j];
+          }
         }
       }
       
@@ -358,7 +423,7 @@ void LSDCatchmentModel::load_data()
     try
     {
       bedrockR.read_ascii_raster(BEDROCK_FILENAME);
-      bedrock = bedrockR.get_RasterData_dbl();
+      bedrock = LSDGrid<double>(bedrockR.get_RasterData_dbl());
       std::cout << "The bedrock file: " << BEDROCK_FILENAME << " was successfully read." << std::endl;
     }
     catch (...)
@@ -412,8 +477,8 @@ void LSDCatchmentModel::load_data()
   }
 }
 
-// Reads in grain data from the grain data file, and initialises the grain_array_tot variable,
-// the index, grain, and strata arrays
+// Reads in grain data from the grain data file, and initialises
+// the index array and the grain records (active layer and strata)
 void LSDCatchmentModel::ingest_graindata_from_file(std::string GRAINDATA_FILENAME)
 {
   std::cout << "\n Loading graindata from the the graindata file: " <<
@@ -426,7 +491,8 @@ void LSDCatchmentModel::ingest_graindata_from_file(std::string GRAINDATA_FILENAM
   // Index coordinates
   unsigned x1=0, y1=0;
   
-  grain_array_tot = 0;
+  int record = 0;
+  LSDStrata& strata = grain.get_strata();
   
   std::string line;
   
@@ -442,7 +508,7 @@ void LSDCatchmentModel::ingest_graindata_from_file(std::string GRAINDATA_FILENAM
     split_delimited_string(line, ' ', line_vector);
     
     unsigned col_counter = 1;
-    grain_array_tot++;
+    record = grain.allocate();
     
     for (unsigned x=0; x<=line_vector.size()-1; x++ )
     {
@@ -456,7 +522,7 @@ void LSDCatchmentModel::ingest_graindata_from_file(std::string GRAINDATA_FILENAM
       
       if (col_counter == 3)
       {
-        index[x1][y1] = grain_array_tot;
+        index[x1][y1] = record;
       }
       
       // Next bunch of columns are grain fractions (surface). Update them.
@@ -464,7 +530,7 @@ void LSDCatchmentModel::ingest_graindata_from_file(std::string GRAINDATA_FILENAM
       {
         if (col_counter==4+n)
         {
-          grain[grain_array_tot][n] = std::stod(line_vector[x]);
+          grain[record][n] = std::stod(line_vector[x]);
         }
       }
       
@@ -476,7 +542,7 @@ void LSDCatchmentModel::ingest_graindata_from_file(std::string GRAINDATA_FILENAM
         {
           if (col_counter == (4+G_MAX+n+1) + (z*9))
           {
-            strata[grain_array_tot][z][n] = std::stod(line_vector[x]);
+            strata.layer(record, z)[n] = std::stod(line_vector[x]);
           }
         }
       }
@@ -828,6 +894,18 @@ void LSDCatchmentModel::initialise_variables(std::string pname, std::string pfna
       ERODEFACTOR = atof(value.c_str());
       std::cout << "erosion limit per timestep: " << ERODEFACTOR << std::endl;
     }
+    else if (lower == "erode_timestep_type")
+    {
+      if (value == "1" || value == "local") erode_timestep_type = 1;
+      else if (value == "0" || value == "default") erode_timestep_type = 0;
+      else
+      {
+        std::cout << "\nFATAL ERROR: erode_timestep_type must be 0 (or default) or 1 (or local), not \""
+                  << value << "\"" << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      std::cout << "erode_timestep_type: " << erode_timestep_type << std::endl;
+    }
 
     /// LATERAL EROSION ROUTINE PARAMETERS
     else if (lower == "lateral_erosion_on")
@@ -948,6 +1026,12 @@ void LSDCatchmentModel::initialise_variables(std::string pname, std::string pfna
       std::cout << "in-output difference allowed (cumecs): " << in_out_difference_allowed << std::endl;
     }
 
+    else if (lower == "wet_area_dry_scans")
+    {
+      wet_area_dry_scans = atoi(value.c_str());
+      std::cout << "wet area scans before dry cells are dropped: " << wet_area_dry_scans << std::endl;
+    }
+
     else if (lower == "min_q_for_depth_calc")
     {
       MIN_Q = atof(value.c_str());
@@ -1006,6 +1090,11 @@ void LSDCatchmentModel::initialise_variables(std::string pname, std::string pfna
       spatially_complex_rainfall = (value == "yes") ? true : false;
       std::cout << "Spatially complex rainfall option: " << spatially_complex_rainfall << std::endl;
     }
+    else if (lower == "deterministic_reductions")
+    {
+      deterministic_reductions = (value == "yes") ? true : false;
+      std::cout << "Deterministic reductions: " << deterministic_reductions << std::endl;
+    }
 
 
     //=-=-=-=-=-=-=-=-=-=-=-=-=-=
@@ -1107,44 +1196,34 @@ void LSDCatchmentModel::initialise_arrays()
   std::cout << "Cartesian imax (no. of rows): " << imax << \
                " Cartesian jmax (no. of cols): " << jmax << std::endl;
 
-  // Need to change this so it does not waste memory assigning arrays 
-  // when running in hydro mode etc.
-  elev = TNT::Array2D<double> (imax+2,jmax+2, -9999);
-  water_depth = TNT::Array2D<double> (imax+2,jmax+2, 0.0);
+  // Arrays are only allocated for the processes that are switched on:
+  // a hydro only run needs none of the sediment, vegetation or lateral
+  // erosion arrays. See print_memory_report() for what was allocated.
+  elev = LSDGrid<double>(imax+2,jmax+2, -9999);
+  water_depth = LSDGrid<double>(imax+2,jmax+2, 0.0);
 
   // Cast to int and then double, what?
   //old_j_mean_store = new double[(int)((maxcycle*60)/input_time_step)+10];
   old_j_mean_store = std::vector<double> (static_cast<int>((maxcycle*60)/input_time_step)+10);
 
-  qx = TNT::Array2D<double> (imax + 2, jmax + 2, 0.0);
-  qy = TNT::Array2D<double> (imax + 2, jmax + 2, 0.0);
-
-  qxs = TNT::Array2D<double> (imax + 2, jmax + 2, 0.0);
-  qys = TNT::Array2D<double> (imax + 2, jmax + 2, 0.0);
+  qx = LSDGrid<double>(imax + 2, jmax + 2, 0.0);
+  qy = LSDGrid<double>(imax + 2, jmax + 2, 0.0);
 
-  Vel = TNT::Array2D<double> (imax + 2, jmax + 2, 0.0);
-
-  area = TNT::Array2D<double> (imax+2, jmax + 2, 0.0);
-  index = TNT::Array2D<int> (imax +2, jmax + 2, 0);
-  elev_diff = TNT::Array2D<double> (imax + 2, jmax + 2);
-
-  bedrock = TNT::Array2D<double> (imax+2, jmax+2, -9999);
-  tempcreep = TNT::Array2D<double> (imax+2,jmax+2);
-  init_elevs = TNT::Array2D<double> (imax+2,jmax+2, -9999);
-
-  vel_dir = TNT::Array3D<double> (imax+2, jmax+2, 9, 0.0);
-  
-  Vsusptot = TNT::Array2D<double> (imax+2,jmax+2, 0.0);
-
-  // Will come back to this later - DAV
-  //if (vegetation_on)
-  //{
-    veg = TNT::Array3D<double> (imax+1, jmax+1, 4, 0.0);
-  //}
+  area = LSDGrid<double>(imax+2, jmax + 2, 0.0);
+  area_depth = LSDGrid<double>(imax + 2, jmax + 2, 0.0);
+  rfarea = TNT::Array2D<int> (imax + 2, jmax + 2, 0);
 
+  // only needed for the elevation difference output
+  if (write_elevdiff_file)
+  {
+    init_elevs = LSDGrid<double>(imax+2,jmax+2, -9999);
+  }
 
   //cross_scan = TNT::Array2D<int> (imax+2,jmax+2, 0);
-  down_scan = TNT::Array2D<int> (jmax+2, imax+2, 0);
+  down_scan = LSDGrid<int>(imax+2, jmax+2, 0);
+  down_scan_count = std::vector<int>(imax+2, 0);
+  wet_scan = LSDGrid<int>(imax+2, jmax+2, INT_MIN/2);
+  scan_number = 0;
 
   // line to stop max time step being greater than rain time step
   if (rain_data_time_step < 1) rain_data_time_step = 1;
@@ -1166,26 +1245,13 @@ void LSDCatchmentModel::initialise_arrays()
   // Does this represent 10000 years? - not sure where/why this is used in CAESAR-LISFLOOD - DV
   //climate_data = TNT::Array2D<double> (10001, 3);
 
- 
-
-  inputpointsarray = TNT::Array2D <bool> (imax + 2, jmax + 2);
-
-  edge = TNT::Array2D<double> (imax+1,jmax+1, 0.0);
-  edge2 = TNT::Array2D<double> (imax+1,jmax+1, 0.0);
-
-  Tau = TNT::Array2D<double> (imax+2,jmax+2, 0.0);
-
   catchment_input_x_coord = std::vector<int> (jmax * imax, 0);
   catchment_input_y_coord = std::vector<int> (jmax * imax, 0);
 
-  area_depth = TNT::Array2D<double> (imax + 2, jmax + 2, 0.0);
-
   //dischargeinput = TNT::Array2D<double> (1000,5);
 
   //hydrograph = TNT::Array2D<double> ( (maxcycle -(static_cast<int>(cycle/60))) + 1000, 2);
 
-  
-
   // Grain Arrays
 
   sum_grain = std::vector<double> (G_MAX+1);
@@ -1207,32 +1273,129 @@ void LSDCatchmentModel::initialise_arrays()
   j_mean = std::vector<double> (rfnum + 1);  // std::vectors will be default initalised to 0, unless specified
   old_j_mean = std::vector<double> (rfnum + 1);
   new_j_mean = std::vector<double> (rfnum + 1);
-  rfarea = TNT::Array2D<int> (imax + 2, jmax + 2, 0);
   nActualGridCells = std::vector<int> (rfnum + 1);
   catchment_input_counter = std::vector<int> (rfnum + 1);
   //catchment_input_counter_big = std::vector<int> (imax +1 *jmax +1);
 
+  // Initialise suspended fraction vector
+  // Tells program whether sediment is suspended fraction or not
+  // TO DO
+  // DAV - Hard coded in that the 1st fraction is suspended: needs
+  // to be red from a separate input file at later date.
+  // (There is no sediment, and so no suspended sediment, in a
+  // hydro only run.)
+  isSuspended = std::vector<bool>(G_MAX+1, false);
+  isSuspended[1] = !hydro_only;
+  fallVelocity = std::vector<double>(G_MAX+1, 0.0);
+  set_fall_velocities();
+
   if (!hydro_only)
-  {  
+  {
+    if (suspended_sediment_on())
+    {
+      qxs = LSDGrid<double>(imax + 2, jmax + 2, 0.0);
+      qys = LSDGrid<double>(imax + 2, jmax + 2, 0.0);
+      Vsusptot = LSDGrid<double>(imax+2,jmax+2, 0.0);
+    }
+
+    // Bedload, bedrock, creep and landsliding
+    Vel = LSDGrid<double>(imax + 2, jmax + 2, 0.0);
+    Tau = LSDGrid<double>(imax+2,jmax+2, 0.0);
+    vel_dir = LSDFaceVelocities(imax+2, jmax+2);
+    bedrock = LSDGrid<double>(imax+2, jmax+2, -9999);
+    tempcreep = LSDGrid<double>(imax+2,jmax+2);
+    index = TNT::Array2D<int> (imax +2, jmax + 2, 0);
+    inputpointsarray = TNT::Array2D <bool> (imax + 2, jmax + 2);
+
+    // Lateral erosion (erode reads the edge values as well)
+    if (lateral_erosion_on)
+    {
+      edge = TNT::Array2D<double> (imax+1,jmax+1, 0.0);
+      edge2 = TNT::Array2D<double> (imax+1,jmax+1, 0.0);
+    }
+
     sr = TNT::Array3D<double> (imax + 2, jmax + 2, 10, 0.0);
     sl = TNT::Array3D<double> (imax + 2, jmax + 2, 10, 0.0);
     su = TNT::Array3D<double> (imax + 2, jmax + 2, 10, 0.0);
     sd = TNT::Array3D<double> (imax + 2, jmax + 2, 10, 0.0);
     ss = TNT::Array2D<double> (imax + 2, jmax + 2, 0.0);
     
-    strata = TNT::Array3D<double> ( ((imax+2)*(jmax+2))/LIMIT , 10, G_MAX+1, 0.0);
-    grain = TNT::Array2D<double> ( ((2+imax)*(jmax+2))/LIMIT, G_MAX+1 , 0.0);
+    // at most one record per cell; the storage grows as records are taken
+    grain = LSDGrainPool( (imax+2)*(jmax+2), 10, G_MAX+1, 0.0);
     temp_grain = std::vector<double> (G_MAX+1, 0.0);
-    
-  }
 
-  // Initialise suspended fraction vector
-  // Tells program whether sediment is suspended fraction or not
-  isSuspended = std::vector<bool>(G_MAX+1, false);
-  fallVelocity = std::vector<double>(G_MAX+1, 0.0);
-  set_fall_velocities();
+    if (vegetation_on)
+    {
+      veg = TNT::Array3D<double> (imax+1, jmax+1, 4, 0.0);
+    }
+  }
 
   zero_values();
+
+  print_memory_report();
+}
+
+// Bytes taken by the arrays of the different kinds
+template <class T>
+static size_t array_bytes(const LSDGrid<T>& array)
+{
+  return size_t(array.dim1()) * array.get_stride() * sizeof(T);
+}
+template <class T>
+static size_t array_bytes(const TNT::Array2D<T>& array)
+{
+  return size_t(array.dim1()) * array.dim2() * sizeof(T);
+}
+template <class T>
+static size_t array_bytes(const TNT::Array3D<T>& array)
+{
+  return size_t(array.dim1()) * array.dim2() * array.dim3() * sizeof(T);
+}
+
+void LSDCatchmentModel::print_memory_report()
+{
+  std::vector< std::pair<std::string, size_t> > arrays = {
+    { "elev", array_bytes(elev) },
+    { "water_depth", array_bytes(water_depth) },
+    { "qx, qy", array_bytes(qx) + array_bytes(qy) },
+    { "area, area_depth", array_bytes(area) + array_bytes(area_depth) },
+    { "rfarea", array_bytes(rfarea) },
+    { "down_scan, wet_scan", array_bytes(down_scan) + array_bytes(wet_scan) },
+    { "init_elevs", array_bytes(init_elevs) },
+    { "qxs, qys, Vsusptot", array_bytes(qxs) + array_bytes(qys) + array_bytes(Vsusptot) },
+    { "Vel, Tau", array_bytes(Vel) + array_bytes(Tau) },
+    { "vel_dir", array_bytes(vel_dir.get_faces()) },
+    { "bedrock", array_bytes(bedrock) },
+    { "tempcreep", array_bytes(tempcreep) },
+    { "index", array_bytes(index) },
+    { "inputpointsarray", array_bytes(inputpointsarray) },
+    { "edge, edge2", array_bytes(edge) + array_bytes(edge2) },
+    { "sr, sl, su, sd, ss", array_bytes(sr) + array_bytes(sl) + array_bytes(su) + array_bytes(sd) + array_bytes(ss) },
+    { "veg", array_bytes(veg) }
+  };
+
+  const std::ios_base::fmtflags flags = std::cout.flags();
+  const std::streamsize precision = std::cout.precision();
+
+  size_t total = 0;
+  std::cout << "Memory allocated for the model grids (MB):" << std::endl;
+  for (const auto& array : arrays)
+  {
+    if (array.second > 0)
+    {
+      std::cout << "  " << std::left << std::setw(22) << array.first
+                << std::fixed << std::setprecision(1) << array.second / 1048576.0 << std::endl;
+      total += array.second;
+    }
+  }
+  std::cout << "  " << std::left << std::setw(22) << "total"
+            << std::fixed << std::setprecision(1) << total / 1048576.0 << std::endl;
+  std::cout.flags(flags);
+  std::cout.precision(precision);
+  if (!hydro_only)
+  {
+    std::cout << "  (plus the grain size records, allocated as cells are eroded)" << std::endl;
+  }
 }
 
 // Hard coded! - Should make this read from sediment details file.
@@ -1456,104 +1619,16 @@ void LSDCatchmentModel::drainage_area_D8()
   // new routine for determining drainage area 4/10/2010
   // instead of using sweeps this sorts all the elevations then works frmo the
   // highest to lowest - calculating drainage area - D-infinity basically.
+  update_drainage_order();
 
-  // zero load of arrays
-  std::vector<double> tempvalues((imax+2) *(jmax+2));
-  std::vector<double> tempvalues2((imax+2) * (jmax+2));
-  std::vector<double> xkey((imax+2)*(jmax+2));
-  std::vector<double> ykey((imax+2)*(jmax+2));
-
-  // then create temp array based on elevs then also one for x values.
-  int inc = 1;
+  // The total drop to the lower neighbours of each cell only depends on
+  // the elevations, so is worked out for all cells at once beforehand
+  LSDGrid<double> difftot(imax + 2, jmax + 2, 0.0);
+  #pragma omp parallel for schedule(static)
   for (unsigned i = 1; i <= imax; i++)
   {
     for (unsigned j = 1; j <= jmax; j++)
     {
-      // tempvalues is just a list of all the elevations in the grid.
-      tempvalues[inc] = elev[i][j];  // bad name choice 'temp'! TO DO: DAV change later
-      // xkey is the xcoordinates collated
-      xkey[inc] = i; // because [row][column] order, so j is the x-coord
-      inc++;
-    }
-  }
-
-  // then sorts according to elevations - but also sorts the key (xkey) according to
-  // these too..
-
-  // Comment about the original CAESAR-Lisflood code
-  // DAV note 09/01/2014 This seems strange at first because the C# syntax is to have
-  // keys first, then values:
-  // Array.sort(keys,values) but here it is Array.sort(values, keys) which seems like
-  // a mistake at first.
-  // So in effect this is *sorting the keys* (1,2,3,4,5,...,n) **according to the
-  // elevations**.
-  //Array.Sort(tempvalues, xkey); (Only available in the C# libraries)
-
-  // DAV 2014-01-12
-  // Written up a template that should roughly replicate the behaviour
-  // Template comparator will function on a std::pair, so you need to compress
-  // the two vectors into a std::pair object first. std::sort is then used with the
-  // comparator, (the template): sort_pair_second. As the name indicates, it sorts
-  // std::pair objects by the second value in the pair. (You could change this if
-  // needed. - thank you stackoverflow!
-
-  // Pair the vectors up
-  std::vector<std::pair<double,double> >
-      x_keys_elevs_paired(xkey.size() < tempvalues.size() ? xkey.size() : tempvalues.size() );
-
-  for (unsigned k=0; k < x_keys_elevs_paired.size(); k++)
-  {
-    x_keys_elevs_paired[k] = std::make_pair(xkey[k],tempvalues[k]);
-  }
-
-  // Now do the sort
-  std::sort(x_keys_elevs_paired.begin(),
-            x_keys_elevs_paired.end(),
-            sort_pair_second<double,double>() );
-
-  // now does the same for y values, creating a temporary array for the ykeys etc.
-  inc = 1;
-  for (unsigned i = 1; i <= imax; i++)
-  {
-    for (unsigned j = 1; j <= jmax; j++)
-    {
-      tempvalues2[inc] = elev[i][j];
-      ykey[inc] = j;  // row-major, so i is the y coordinate (the row of NRows)
-      inc++;
-    }
-  }
-  // Create a suitably sized vector to hold the pairs
-  std::vector<std::pair<double,double> >
-      y_keys_elevs_paired(ykey.size() < tempvalues2.size() ? ykey.size() : tempvalues2.size() );
-
-
-  // Pair the vectors of keys and tempvalues (elevs) up.
-  for (unsigned k=0; k < y_keys_elevs_paired.size(); k++)
-  {
-    y_keys_elevs_paired[k] = std::make_pair(ykey[k],tempvalues2[k]);
-  }
-
-  // Now do the sort
-  // DAV- this implentation needs double-checking 1/12/2015
-  std::sort(y_keys_elevs_paired.begin(),
-            y_keys_elevs_paired.end(),
-            sort_pair_second<double,double>() );
-
-  // then works through the list of x and y co-ordinates from highest to lowest...
-  for (unsigned n = (jmax * imax); n >= 1; n--)
-  {
-    int i = static_cast<int>(std::get<0>(x_keys_elevs_paired[n]) );
-    int j = static_cast<int>(std::get<0>(y_keys_elevs_paired[n]) );
-
-    // I.e. If we are in the catchment (area_depth = 0 in NODATA)
-    if (area_depth[i][j] > 0)
-    {
-      // update area if area_depth is higher
-      // That is, set the area to a value if in catchment
-      if (area_depth[i][j] > area[i][j]) area[i][j] = area_depth[i][j];
-
-      double difftot = 0;
-
       // work out sum of +ve slopes in all 8 directions
       for (int dir = 1; dir <= 8; dir++)//was 1 to 8 +=2
       {
@@ -1562,8 +1637,8 @@ void LSDCatchmentModel::drainage_area_D8()
 
         if (j2 < 1) j2 = 1;
         if (i2 < 1) i2 = 1;
-        if (j2 > jmax) j2 = jmax;
-        if (i2 > imax) i2 = imax;
+        if (j2 > static_cast<int>(jmax)) j2 = jmax;
+        if (i2 > static_cast<int>(imax)) i2 = imax;
 
         // swap comment lines below for drainage area from D8 or Dinfinity
         // Calculates the total drop (difference) in elevation of surrounding cells
@@ -1571,17 +1646,33 @@ void LSDCatchmentModel::drainage_area_D8()
         // D8
         if (dir % 2 != 0)
         {
-          if (elev[i2][j2] < elev[i][j]) difftot += elev[i][j] - elev[i2][j2];
+          if (elev[i2][j2] < elev[i][j]) difftot[i][j] += elev[i][j] - elev[i2][j2];
         }
         else
         {
-          if (elev[i2][j2] < elev[i][j]) difftot += (elev[i][j] - elev[i2][j2]) / 1.414;
+          if (elev[i2][j2] < elev[i][j]) difftot[i][j] += (elev[i][j] - elev[i2][j2]) / 1.414;
         }
         //if(elev[x][y]-elev[x2][y2]>difftot) difftot=elev[x][y]-elev[x2][y2];
       }
+    }
+  }
+
+  // then works through the list of cells from highest to lowest...
+  const unsigned stride = jmax + 2;
+  for (unsigned n = 0; n < drainage_order.size(); n++)
+  {
+    int i = drainage_order[n] / stride;
+    int j = drainage_order[n] % stride;
+
+    // I.e. If we are in the catchment (area_depth = 0 in NODATA)
+    if (area_depth[i][j] > 0)
+    {
+      // update area if area_depth is higher
+      // That is, set the area to a value if in catchment
+      if (area_depth[i][j] > area[i][j]) area[i][j] = area_depth[i][j];
 
       // Will there be any flow distribution?
-      if (difftot > 0)
+      if (difftot[i][j] > 0)
       {
         // then distribute to all 8...
         for (int dir = 1; dir <= 8; dir++)//was 1 to 8 +=2
@@ -1593,17 +1684,17 @@ void LSDCatchmentModel::drainage_area_D8()
           // Make sure we don't go over the edges of the model domain
           if (j2 < 1) j2 = 1;
           if (i2 < 1) i2 = 1;
-          if (j2 > jmax) j2 = jmax;
-          if (i2 > imax) i2 = imax;
+          if (j2 > static_cast<int>(jmax)) j2 = jmax;
+          if (i2 > static_cast<int>(imax)) i2 = imax;
 
           // swap comment lines below for drainage area from D8 or Dinfinity
           if (dir % 2 != 0)
           {
-            if (elev[i2][j2] < elev[i][j]) area_depth[i2][j2] += area_depth[i][j] * ((elev[i][j] - elev[i2][j2]) / difftot);
+            if (elev[i2][j2] < elev[i][j]) area_depth[i2][j2] += area_depth[i][j] * ((elev[i][j] - elev[i2][j2]) / difftot[i][j]);
           }
           else
           {
-            if (elev[i2][j2] < elev[i][j]) area_depth[i2][j2] += area_depth[i][j] * (((elev[i][j] - elev[i2][j2])/1.414) / difftot);
+            if (elev[i2][j2] < elev[i][j]) area_depth[i2][j2] += area_depth[i][j] * (((elev[i][j] - elev[i2][j2])/1.414) / difftot[i][j]);
           }
 
           //if (elev[x][y] - elev[x2][y2] == difftot) area_depth[x2][y2] += area_depth[x][y];
@@ -1617,6 +1708,58 @@ void LSDCatchmentModel::drainage_area_D8()
 
 }
 
+// Puts drainage_order (the cells x*(jmax+2)+y, from the highest to the
+// lowest) in order. The order is kept from the last call: if erosion has
+// not changed it (checked in one parallel pass), there is nothing to do,
+// otherwise it is sorted again from there.
+//
+// Cells of the same elevation never pass area to each other, so their
+// order among themselves makes no difference.
+void LSDCatchmentModel::update_drainage_order()
+{
+  const unsigned stride = jmax + 2;
+  if (drainage_order.size() != size_t(imax) * jmax)
+  {
+    drainage_order.clear();
+    drainage_order.reserve(size_t(imax) * jmax);
+    for (unsigned i = 1; i <= imax; i++)
+    {
+      for (unsigned j = 1; j <= jmax; j++)
+      {
+        drainage_order.push_back(i * stride + j);
+      }
+    }
+  }
+  else
+  {
+    long out_of_order = 0;
+    #pragma omp parallel for reduction(+:out_of_order) schedule(static)
+    for (unsigned n = 1; n < drainage_order.size(); n++)
+    {
+      if (elev[drainage_order[n - 1] / stride][drainage_order[n - 1] % stride] <
+          elev[drainage_order[n] / stride][drainage_order[n] % stride])
+      {
+        out_of_order++;
+      }
+    }
+    if (out_of_order == 0) return;
+  }
+
+  // Sort (elevation, cell) pairs, highest first
+  std::vector< std::pair<double, int> > elev_cells(drainage_order.size());
+  #pragma omp parallel for schedule(static)
+  for (unsigned n = 0; n < drainage_order.size(); n++)
+  {
+    int cell = drainage_order[n];
+    elev_cells[n] = std::make_pair(elev[cell / stride][cell % stride], cell);
+  }
+  std::sort(elev_cells.begin(), elev_cells.end(), std::greater< std::pair<double, int> >());
+  for (unsigned n = 0; n < elev_cells.size(); n++)
+  {
+    drainage_order[n] = elev_cells[n].second;
+  }
+}
+
 // =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 // WRAPPER FUNCTIONS TO CARRY OUT EROSION ETC
 // =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
@@ -1642,7 +1785,7 @@ void LSDCatchmentModel::call_erosion()
 // not sure about the necessity of this call...
 void LSDCatchmentModel::call_lateral()
 {
-  if (counter >= lateralcounter)
+  if (lateral_erosion_on && counter >= lateralcounter)
   {
     lateral3();   // call the actual erosion function
     lateralcounter = counter + (50 * erode_mult);
@@ -2021,7 +2164,7 @@ void LSDCatchmentModel::save_raster_data(double tempcycle)
     // TO DO
     // This will actually write out the border cells which is incorrect technically
     // Find a way to trim these off.
-    LSDRaster water_depthR(imax+2, jmax+2, xll, yll, DX, no_data_value, water_depth);
+    LSDRaster water_depthR(imax+2, jmax+2, xll, yll, DX, no_data_value, water_depth.to_Array2D());
 
     // Strip the padding of zeros round the edge
     water_depthR.strip_raster_padding();
@@ -2037,7 +2180,7 @@ void LSDCatchmentModel::save_raster_data(double tempcycle)
   // Write Elevation raster
   if (write_elev_file == true)
   {
-    LSDRaster elev_outR(imax+2, jmax+2, xll, yll, DX, no_data_value, elev);
+    LSDRaster elev_outR(imax+2, jmax+2, xll, yll, DX, no_data_value, elev.to_Array2D());
     // Get rid of the zeros padding the edges of the domain
     elev_outR.strip_raster_padding();
     
@@ -2052,7 +2195,7 @@ void LSDCatchmentModel::save_raster_data(double tempcycle)
     std::cout << "Entering the GRAINMATRIX..." << std::endl;
     LSDGrainMatrix grainsz_outR(imax, jmax, \
                                 no_data_value, G_MAX, \
-                                index, grain, strata);
+                                index, grain);
     
     std::string OUTPUT_GRAIN_FILE = write_path + "/" + grainsize_fname + std::to_string((int)tempcycle);
     
@@ -2062,7 +2205,7 @@ void LSDCatchmentModel::save_raster_data(double tempcycle)
   // Write the elev diff file
   if (write_elevdiff_file == true)
   {
-    TNT::Array2D<double> elevdiff_now = init_elevs - elev; // test this
+    TNT::Array2D<double> elevdiff_now = init_elevs.to_Array2D() - elev.to_Array2D();
     
     LSDRaster elevdiff_outR(imax+2, jmax+2, xll, yll, DX, no_data_value, elevdiff_now);
     elevdiff_outR.strip_raster_padding();
@@ -2173,66 +2316,73 @@ void LSDCatchmentModel::zero_values()
   {
     for(unsigned j=0; j <= jmax+1; j++)
     {
-      Vel[i][j] = 0;
       area[i][j] = 0;
       elev[i][j] = -9999;
-      bedrock[i][j] = -9999;
-      init_elevs[i][j] = elev[i][j];
       water_depth[i][j] = 0;
-      index[i][j] = -9999;
-      inputpointsarray[i][j] = false;
 
       qx[i][j] = 0;
       qy[i][j] = 0;
 
-      qxs[i][j] = 0;
-      qys[i][j] = 0;
-
-      for(int n=0; n<=8; n++)
-      {
-        vel_dir[i][j][n]=0;
-      }
-
-      Vsusptot[i][j] = 0;
       rfarea[i][j] = 1;
     }
   }
 
-  // These arrays are different dimensions
-  // So they need to be zeroed differently
-  for (unsigned i=0; i<=imax; i++)
+  if (write_elevdiff_file)
   {
-    for(unsigned j=0; j<=jmax; j++)
-    {
-      if (vegetation_on)
-      {  
-        veg[i][j][0] = 0;// elevation
-        veg[i][j][1] = 0; // densitj
-        veg[i][j][2] = 0; // jw density
-        veg[i][j][3] = 0; // height
-      }
-      edge[i][j] = 0;
-      edge2[i][j] = 0;
-    }
+    init_elevs.fill(-9999);
   }
 
-  for(unsigned i=1; i<((jmax*imax)/LIMIT); i++)
+  if (!hydro_only)
   {
-    if (!hydro_only)
+    for(unsigned i=0; i <= imax+1; i++)
     {
-      for(unsigned j=0; j<=G_MAX; j++)
+      for(unsigned j=0; j <= jmax+1; j++)
       {
-        grain[i][j] = 0;
+        Vel[i][j] = 0;
+        bedrock[i][j] = -9999;
+        index[i][j] = -9999;
+        inputpointsarray[i][j] = false;
+
+        if (suspended_sediment_on())
+        {
+          qxs[i][j] = 0;
+          qys[i][j] = 0;
+
+          Vsusptot[i][j] = 0;
+        }
       }
-      for(int z=0; z <= 9; z++)
+    }
+    vel_dir.zero();
+
+    // These arrays are different dimensions
+    // So they need to be zeroed differently
+    for (unsigned i=0; i<=imax; i++)
+    {
+      for(unsigned j=0; j<=jmax; j++)
       {
-        for(unsigned j=0; j <= G_MAX-2; j++)
+        if (vegetation_on)
+        {  
+          veg[i][j][0] = 0;// elevation
+          veg[i][j][1] = 0; // densitj
+          veg[i][j][2] = 0; // jw density
+          veg[i][j][3] = 0; // height
+        }
+        if (lateral_erosion_on)
         {
-          strata[i][z][j] =0;
+          edge[i][j] = 0;
+          edge2[i][j] = 0;
         }
       }
     }
-  
+  }
+
+  if (!hydro_only)
+  {
+    grain.fill(0);
+  }
+
+  for(unsigned i=1; i<((jmax*imax)/LIMIT); i++)
+  {
     catchment_input_x_coord[i] = 0;
     catchment_input_y_coord[i] = 0;
   }
@@ -2250,11 +2400,6 @@ void LSDCatchmentModel::zero_values()
     new_j_mean[i] = 0;
   }
 
-  // TO DO
-  // DAV - Hard coded in that the 1st fraction is suspended: needs
-  // to be red from a separate input file at later date.
-  isSuspended[1] = true;
-
 }
 
 // __________________________________________
@@ -2336,23 +2481,13 @@ void LSDCatchmentModel::flow_route()
 {
   double local_time_factor = set_local_timefactor();
   
-  #pragma omp parallel for
-  for (unsigned y=1; y<=jmax; y++)
+  #pragma omp parallel for schedule(dynamic)
+  for (unsigned s=0; s<wet_spans.size(); s++)
   {
-    int inc = 1;
-    while (down_scan[y][inc] > 0)
-    {
-////      __builtin_prefetch(&water_depth[down_scan[y][inc+1]-1][y-1]);
-////      __builtin_prefetch(&water_depth[down_scan[y][inc+1]-1][y]);
-////      __builtin_prefetch(&water_depth[down_scan[y][inc+1]][y-1]);
-////      __builtin_prefetch(&water_depth[down_scan[y][inc+1]][y]);
-////      __builtin_prefetch(&elev[down_scan[y][inc+1]-1][y]);
-////      __builtin_prefetch(&elev[down_scan[y][inc+1]-1][y-1]);
-////      __builtin_prefetch(&elev[down_scan[y][inc+1]][y]);
-////      __builtin_prefetch(&elev[down_scan[y][inc+1]][y-1]);
-      
-      unsigned x = down_scan[y][inc];
-      inc++;
+    const unsigned x = wet_spans[s].x;
+    for (int inc = wet_spans[s].first; inc < wet_spans[s].last; inc++)
+    {
+      unsigned y = down_scan[x][inc];
       if (elev[x][y] > -9999) // to stop moving water in to -9999's on elev
       {
         // routing in x direction
@@ -2402,17 +2537,20 @@ void LSDCatchmentModel::flow_route()
                 qxs[x][y] = 0 - ((Vsusptot[x - 1][y] * DX) / 5) / local_time_factor;
             }
 
-            // calc velocity now
-            if (qx[x][y] > 0)
-              vel_dir[x][y][7] = qx[x][y] / hflow;
-            if (qx[x][y] < 0)
-              vel_dir[x - 1][y][3] = (0- qx[x][y]) / hflow;
+            // calc velocity now (only erosion uses it)
+            if (!hydro_only)
+            {
+              if (qx[x][y] > 0)
+                vel_dir(x, y, 7) = qx[x][y] / hflow;
+              if (qx[x][y] < 0)
+                vel_dir(x - 1, y, 3) = (0- qx[x][y]) / hflow;
+            }
 
           }
           else
           {
             qx[x][y] = 0;
-            qxs[x][y] = 0;
+            if (isSuspended[1]) qxs[x][y] = 0;
           }
         }
 
@@ -2455,14 +2593,17 @@ void LSDCatchmentModel::flow_route()
 
             }
 
-            // calc velocity now
-            if (qy[x][y] > 0) vel_dir[x][y][1] = qy[x][y] / hflow;
-            if (qy[x][y] < 0) vel_dir[x][y - 1][5] = (0 - qy[x][y]) / hflow;
+            // calc velocity now (only erosion uses it)
+            if (!hydro_only)
+            {
+              if (qy[x][y] > 0) vel_dir(x, y, 1) = qy[x][y] / hflow;
+              if (qy[x][y] < 0) vel_dir(x, y - 1, 5) = (0 - qy[x][y]) / hflow;
+            }
           }
           else
           {
             qy[x][y] = 0;
-            qys[x][y] = 0;
+            if (isSuspended[1]) qys[x][y] = 0;
           }
         }
 
@@ -2487,15 +2628,14 @@ void LSDCatchmentModel::depth_update()
 
   maxdepth = 0;
   double l_maxdepth = maxdepth;
-  #pragma omp parallel for reduction(max:l_maxdepth)
-  for (unsigned y = 1; y<= jmax; y++)
+  #pragma omp parallel for reduction(max:l_maxdepth) schedule(dynamic)
+  for (unsigned s = 0; s < wet_spans.size(); s++)
   {
-    int inc = 1;
+    const unsigned x = wet_spans[s].x;
     double tempmaxdepth = 0;
-    while (down_scan[y][inc] > 0)
+    for (int inc = wet_spans[s].first; inc < wet_spans[s].last; inc++)
     {
-      unsigned x = down_scan[y][inc];
-      inc++;
+      unsigned y = down_scan[x][inc];
 
       // update water depths
       water_depth[x][y] += local_time_factor * (qx[x + 1][y] - qx[x][y] + qy[x][y + 1] - qy[x][y]) / DX;
@@ -2526,26 +2666,27 @@ void LSDCatchmentModel::depth_update()
 // DAV - This can be split into subfunctions
 void LSDCatchmentModel::catchment_water_input_and_hydrology( double local_time_factor) 
 {
+  // The input of each zone, and the water added to each of its input
+  // points. Summed over the zones in order, as before.
   // This was added in CL 1.8f but not present in 1.8a:
-  for (unsigned i = 1; i<=rfnum; i++)
+  std::vector<double> zone_water_add(rfnum + 1, 0.0);
+  for (unsigned n = 1; n <= rfnum; n++)
   {
-    waterinput += j_mean[i] * nActualGridCells[i] * DX * DX;
+    waterinput += j_mean[n] * nActualGridCells[n] * DX * DX;
+    if (catchment_input_counter[n] > 0)
+    {
+      zone_water_add[n] = std::min((j_mean[n] * nActualGridCells[n]) /
+                                   (catchment_input_counter[n]) * local_time_factor, ERODEFACTOR);
+    }
   }
-  
+
+  // Each input point is a different cell
+  #pragma omp parallel for schedule(static)
   for (int z=1; z <= totalinputpoints; z++)
   {
     int i = catchment_input_x_coord[z];
     int j = catchment_input_y_coord[z];
-    double water_add_amt = (j_mean[rfarea[i][j]] * nActualGridCells[rfarea[i][j]]) /
-        (catchment_input_counter[rfarea[i][j]]) * local_time_factor;    //
-    if (water_add_amt > ERODEFACTOR)
-    {
-      water_add_amt = ERODEFACTOR;
-    }
-    
-    // Removed now as done above
-    // waterinput += (water_add_amt / local_time_factor) * DX * DX;
-    water_depth[i][j] += water_add_amt;
+    water_depth[i][j] += zone_water_add[rfarea[i][j]];
   }
   // if the input type flag is 1 then the discharge is input from the hydrograph
   if (cycle >= time_1)
@@ -2616,37 +2757,47 @@ void LSDCatchmentModel::catchment_water_input_and_hydrology( double local_time_f
 void LSDCatchmentModel::catchment_water_input_and_hydrology( double local_time_factor,
                                                                  runoffGrid& runoff)     
 {
-  for (unsigned i = 1; i<imax; i++)
+  // The rows are reduced by OpenMP, in an order that depends on the
+  // number of threads. With deterministic_reductions the water input is
+  // instead summed afterwards, serially and in the original order, so it
+  // is the same as the serial code whatever the number of threads.
+  if (deterministic_reductions)
   {
-    for (unsigned j =1; j<jmax; j++)
+    #pragma omp parallel for schedule(static)
+    for (unsigned i=1; i<imax; i++)
     {
-      waterinput += runoff.get_j_mean(i,j) * DX * DX;
+      add_runoff_to_row(i, local_time_factor, runoff);
     }
-  }
-
-  // Not all compilers support reduction of class member variable,
-  // so you'll need to fix it (GCC 6.2 seeps to support it)
-  // workaround by just creating local copy of waterinput here
-  //#pragma omp parallel for reduction(+:waterinput)
-  for (unsigned i=1; i<imax; i++)
-  {
-    for (unsigned j=1; j<jmax; j++)
+    for (unsigned i=1; i<imax; i++)
     {
-      double water_add_amt = runoff.get_j_mean(i,j) * local_time_factor;    //
-  
-      if (water_add_amt > ERODEFACTOR)
+      for (unsigned j=1; j<jmax; j++)
       {
-        water_add_amt = ERODEFACTOR;
+        waterinput += runoff.get_j_mean(i,j) * DX * DX;
+      }
+    }
+    for (unsigned i=1; i<imax; i++)
+    {
+      for (unsigned j=1; j<jmax; j++)
+      {
+        double water_add_amt = std::min(runoff.get_j_mean(i,j) * local_time_factor, ERODEFACTOR);
+        waterinput += (water_add_amt / local_time_factor) * DX * DX;
       }
-  
-      waterinput += (water_add_amt / local_time_factor) * DX * DX;
-  
-      water_depth[i][j] += water_add_amt;
     }
   }
+  else
+  {
+    double input = 0.0;
+    #pragma omp parallel for reduction(+:input) schedule(static)
+    for (unsigned i=1; i<imax; i++)
+    {
+      input += add_runoff_to_row(i, local_time_factor, runoff);
+    }
+    waterinput += input;
+  }
 
   // DAV - testing methodf for new_jmeanmax
   double new_jmeanmax = 0;
+  #pragma omp parallel for reduction(max:new_jmeanmax) schedule(static)
   for (unsigned m=1; m <= imax; m++)
   {
     for (unsigned n=1; n<=jmax; n++)
@@ -2678,6 +2829,27 @@ void LSDCatchmentModel::catchment_water_input_and_hydrology( double local_time_f
   calchydrograph(time_1 - cycle, runoff);
 }
 
+double LSDCatchmentModel::add_runoff_to_row(int i, double local_time_factor,
+                                            const runoffGrid& runoff)
+{
+  double input = 0.0;
+  for (unsigned j=1; j<jmax; j++)
+  {
+    double water_add_amt = runoff.get_j_mean(i,j) * local_time_factor;
+
+    if (water_add_amt > ERODEFACTOR)
+    {
+      water_add_amt = ERODEFACTOR;
+    }
+
+    input += runoff.get_j_mean(i,j) * DX * DX;
+    input += (water_add_amt / local_time_factor) * DX * DX;
+
+    water_depth[i][j] += water_add_amt;
+  }
+  return input;
+}
+
 // Fully distributed TOPMODEL
 void LSDCatchmentModel::topmodel_runoff(double cycle, runoffGrid& runoff)
 {
@@ -2799,6 +2971,7 @@ void LSDCatchmentModel::calchydrograph(double time)
 // rainfall inputs.
 void LSDCatchmentModel::calchydrograph(double time, runoffGrid& runoff)
 {
+  #pragma omp parallel for schedule(static)
   for (unsigned m=1; m<= imax; m++)
   {
     for (unsigned n=1; n <= jmax; n++)
@@ -2872,12 +3045,12 @@ void LSDCatchmentModel::evaporate(double time)
     evap_amount = ERODEFACTOR;
   }
 
-  for (unsigned y=1; y < imax; y++)
+  for (unsigned x=1; x <= imax; x++)
   {
     int inc = 1;
-    while (down_scan[y][inc] > 0)
+    while (down_scan[x][inc] > 0 && down_scan[x][inc] < static_cast<int>(imax))
     {
-      unsigned x = down_scan[y][inc];
+      unsigned y = down_scan[x][inc];
       inc++;
       // removes water in rate of mm per day..
       if (water_depth[x][y] > 0)
@@ -2889,16 +3062,125 @@ void LSDCatchmentModel::evaporate(double time)
   }//);
 }
 
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// WET AREA
+//
+// down_scan lists, for each row x, the y of the cells with water in
+// or next to them, in order and ending with a 0: the only cells the
+// hydrology and erosion loops visit.
+//
+// Water only moves between listed cells (flow_route() and
+// depth_update() only visit those) or is added at the catchment
+// input points, so a cell can only have become wet since the last
+// scan if it is listed or an input point. Instead of checking the
+// neighbourhood of every cell of the grid, scan_area() therefore
+// only looks at those cells: it stamps the neighbourhood of each wet
+// one with the number of the scan, adds the stamped cells that were
+// not listed yet and drops the listed cells whose stamp is more than
+// wet_area_dry_scans scans old. With wet_area_dry_scans = 0 this is
+// exactly the list a full scan would give.
+//
+// With spatially complex rainfall water is added to every cell, so
+// the whole grid is scanned, as it is on the first call.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 void LSDCatchmentModel::scan_area()
 {
+  scan_number++;
+  if (scan_number == 1 || spatially_complex_rainfall)
+  {
+    rescan_area();
+    split_wet_spans();
+    return;
+  }
+  const int oldest = scan_number - wet_area_dry_scans;
+
+  // cells stamped now that were not listed, by row
+  std::vector< std::vector<int> > added(imax + 2);
+
+  // input points first (serially, they stamp neighbouring rows)
+  for (int z = 1; z <= totalinputpoints; z++)
+  {
+    int x = catchment_input_x_coord[z];
+    int y = catchment_input_y_coord[z];
+    if (x < 1 || water_depth[x][y] <= 0) continue;
+    for (unsigned i = std::max(x - 1, 1); i <= std::min<unsigned>(x + 1, imax); i++)
+    {
+      for (unsigned j = std::max(y - 1, 1); j <= std::min<unsigned>(y + 1, jmax); j++)
+      {
+        if (wet_scan[i][j] != scan_number)
+        {
+          if (wet_scan[i][j] < oldest - 1) added[i].push_back(j);
+          wet_scan[i][j] = scan_number;
+        }
+      }
+    }
+  }
+
+  // Stamp each row from the wet listed cells of the rows either side
+  // of it and itself: every row is only written by its own thread
+  #pragma omp parallel for
+  for (unsigned x = 1; x <= imax; x++)
+  {
+    for (unsigned i = std::max<unsigned>(x - 1, 1); i <= std::min(x + 1, imax); i++)
+    {
+      int inc = 1;
+      while (down_scan[i][inc] > 0)
+      {
+        unsigned y = down_scan[i][inc];
+        inc++;
+        if (water_depth[i][y] <= 0) continue;
+        for (unsigned j = std::max<unsigned>(y - 1, 1); j <= std::min(y + 1, jmax); j++)
+        {
+          if (wet_scan[x][j] != scan_number)
+          {
+            if (wet_scan[x][j] < oldest - 1) added[x].push_back(j);
+            wet_scan[x][j] = scan_number;
+          }
+        }
+      }
+    }
+  }
+
+  // Merge the cells still wet enough with the new ones, in order
+  #pragma omp parallel
+  {
+    std::vector<int> row;
+    #pragma omp for
+    for (unsigned x = 1; x <= imax; x++)
+    {
+      if (down_scan_count[x] == 0 && added[x].empty()) continue;
+      std::sort(added[x].begin(), added[x].end());
+      row.clear();
+      std::vector<int>::iterator next = added[x].begin();
+      int inc = 1;
+      while (down_scan[x][inc] > 0)
+      {
+        int y = down_scan[x][inc];
+        inc++;
+        for (; next != added[x].end() && *next < y; ++next) row.push_back(*next);
+        if (wet_scan[x][y] >= oldest) row.push_back(y);
+      }
+      row.insert(row.end(), next, added[x].end());
+
+      std::copy(row.begin(), row.end(), &down_scan[x][1]);
+      down_scan[x][row.size() + 1] = 0;
+      down_scan_count[x] = row.size();
+    }
+  }
+  split_wet_spans();
+}
+
+void LSDCatchmentModel::rescan_area()
+{
+  const int oldest = scan_number - wet_area_dry_scans;
   #pragma omp parallel for
-  for (unsigned j=1; j <= jmax; j++)
+  for (unsigned i=1; i <= imax; i++)
   {
     int inc = 1;
-    for (unsigned i=1; i <= imax; i++)
+    for (unsigned j=1; j <= jmax; j++)
     {
       // zero scan bit..
-      down_scan[j][i] = 0;
+      down_scan[i][j] = 0;
       // and work out scanned area. // TO DO (DAV) there is some out-of-bounds indexing going on here, check carefully!
       if (water_depth[i][j] > 0
           || water_depth[i][j - 1] > 0
@@ -2911,11 +3193,44 @@ void LSDCatchmentModel::scan_area()
           || water_depth[i + 1][j] > 0
           )
       {
-        down_scan[j][inc] = i;
+        wet_scan[i][j] = scan_number;
+      }
+      if (wet_scan[i][j] >= oldest)
+      {
+        down_scan[i][inc] = j;
         inc++;
         // inc will increment everytime there is water found in a cell
       }
     }
+    down_scan[i][inc] = 0;
+    down_scan_count[i] = inc - 1;
+  }
+}
+
+// A river crossing a few rows leaves most rows dry, so the loops over
+// the wet cells share out spans of cells rather than rows: a few times
+// as many spans as threads, none longer than the total divided by that
+// (rows are cut up where they are longer), dynamically scheduled.
+void LSDCatchmentModel::split_wet_spans()
+{
+  const int spans_per_thread = 8;
+  const int min_span_cells = 64;
+
+  long total = 0;
+  for (unsigned x = 1; x <= imax; x++)
+  {
+    total += down_scan_count[x];
+  }
+  int span_cells = std::max<long>(min_span_cells, total / (omp_get_max_threads() * spans_per_thread) + 1);
+
+  wet_spans.clear();
+  for (unsigned x = 1; x <= imax; x++)
+  {
+    for (int first = 1; first <= down_scan_count[x]; first += span_cells)
+    {
+      WetSpan span = { x, first, std::min(first + span_cells, down_scan_count[x] + 1) };
+      wet_spans.push_back(span);
+    }
   }
 }
 
@@ -2944,17 +3259,20 @@ void LSDCatchmentModel::scan_area()
 // =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 void LSDCatchmentModel::sort_active(int x,int y)
 {
-  int xyindex;
-  double total;
-  double amount;
-  double coeff;
-
   if (index[x][y] == -9999)
   {
     addGS(x,y);
   }
 
-  xyindex = index[x][y];
+  sort_active_record(index[x][y]);
+}
+
+void LSDCatchmentModel::sort_active_record(int xyindex)
+{
+  double total;
+  double amount;
+  double coeff;
+  LSDStrata& strata = grain.get_strata();
 
   total = 0.0;
   for (unsigned n = 0;n<=G_MAX;n++)
@@ -2964,16 +3282,9 @@ void LSDCatchmentModel::sort_active(int x,int y)
 
   if (total > (active*1.5)) // depositing - create new strata layer and remove bottom one..
   {
-    // start from bottom
-    // remove bottom active layer
-    // then move all from layer above into one below, up to the top layer
-    for(unsigned z=9;z>=1;z--)
-    {
-      for(unsigned n=0;n<=G_MAX-2;n++)
-      {
-        strata[xyindex][z][n]=strata[xyindex][z-1][n];
-      }
-    }
+    // remove bottom layer and add a new top layer (a copy of the old
+    // top layer until it is filled in)
+    double* top_layer = strata.push(xyindex);
 
     // then remove strata thickness from grain - and add to top strata layer
     coeff = active / total;
@@ -2982,7 +3293,7 @@ void LSDCatchmentModel::sort_active(int x,int y)
       if ((grain[xyindex][n] > 0.0))
       {
         amount = coeff * (grain[xyindex][n]);
-        strata[xyindex][0][n-1] = amount;
+        top_layer[n-1] = amount;
         grain[xyindex][n] -= amount;
       }
     }
@@ -2992,52 +3303,47 @@ void LSDCatchmentModel::sort_active(int x,int y)
   {
     // Start at top
     // Add top strata to grain
+    const double* top_layer = strata.layer(xyindex, 0);
     for (unsigned n=1;n<=(G_MAX-1);n++)
     {
-      grain[xyindex][n] += strata[xyindex][0][n-1];
+      grain[xyindex][n] += top_layer[n-1];
     }
 
-    // then from top down add lower strata into upper
-    for(unsigned z=0;z<=8;z++)
-    {
-      for(unsigned n=0;n<=G_MAX-2;n++)
-      {
-        strata[xyindex][z][n] = strata[xyindex][z+1][n];
-      }
-    }
+    // then remove the top layer, the ones below move up
+    double* bottom_layer = strata.pop(xyindex);
 
     // add new layer at the bottom
     amount = active;
-    int z = 9;
     for (unsigned n=1; n<=G_MAX-1; n++)
     {
-        strata[xyindex][z][n-1] = amount * dprop[n];
+        bottom_layer[n-1] = amount * dprop[n];
     }
   }
 
 }
  // NEW METHOD for N number of grain sizes
+// Thread safe: the record comes from the lock free LSDGrainPool and is
+// filled in and sorted by this thread alone, then published with a
+// compare and swap on index[x][y]. If another thread gave the cell a
+// record first, this one is handed back and the cell keeps the other.
 void LSDCatchmentModel::addGS(int x, int y)
 {
-  #pragma omp critical(addGS)
-  {
+  const int record = grain.allocate();
+  LSDStrata& strata = grain.get_strata();
 
-  grain_array_tot++;
-  index[x][y] = grain_array_tot;
-
-  grain[grain_array_tot][0] = 0;
+  grain[record][0] = 0;
   for (unsigned n = 1; n <= G_MAX - 1;n++ )
   {
-      grain[grain_array_tot][n] = active * dprop[n];
+      grain[record][n] = active * dprop[n];
   }
-  grain[grain_array_tot][G_MAX] = 0;
+  grain[record][G_MAX] = 0;
 
 
   for (unsigned n = 0; n <= 9; n++) // Do we always need 9 strata? Future improvement?
   {
       for (unsigned n2 = 0; n2 <= G_MAX-2; n2++ )
       {
-          strata[grain_array_tot][n][n2] = (active) * dprop[n2+1];
+          strata.layer(record, n)[n2] = (active) * dprop[n2+1];
       }
 
 
@@ -3045,11 +3351,18 @@ void LSDCatchmentModel::addGS(int x, int y)
       {
           for (unsigned q = 0; q <= (G_MAX - 2); q++)
           {
-              strata[grain_array_tot][n][q] = 0;
+              strata.layer(record, n)[q] = 0;
           }
       }
   }
-  sort_active(x, y);
+
+  sort_active_record(record);
+
+  int expected = -9999;
+  if (!__atomic_compare_exchange_n(&index[x][y], &expected, record, false,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+  {
+    grain.release(record);
   }
 }
 
@@ -3284,37 +3597,36 @@ double LSDCatchmentModel::erode(double mult_factor)
   const double rho = 1000.0;
   double tempbmax = 0;
   float gtot2[20] = {};
-  //double local_time_factor = 0;
-  
-  time_factor = time_factor * 1.5;
+
+  // The suspended sediment and lateral erosion arrays are only
+  // allocated when these are on
+  const bool suspended = suspended_sediment_on();
+  const bool lateral = lateral_erosion_on;
   
   // Deal with erosion timestep
-//  switch (erode_timestep_type)
-//  {
-//    case 0:  // Erosion controls global time step and thus next hydro timestep
-//      time_factor = time_factor * 1.5;
-//      if (time_factor > max_time_step) time_factor = max_time_step;
-//      local_time_factor = time_factor;
-//      break;
-      
-//    case 1:  // Erosion uses local timestep: global timestep and thus hydro timestep not affected
-//      local_time_factor = time_factor * 1.5;   
-//      if (local_time_factor > max_time_step) local_time_factor = max_time_step;
-//      break;
-//  }
+  // 0: Erosion controls global time step and thus next hydro timestep.
+  //    The whole sweep is repeated with a smaller time step until no
+  //    cell erodes more than ERODEFACTOR.
+  // 1: Erosion uses local timestep: global timestep and thus hydro
+  //    timestep not affected. A cell that would erode more than
+  //    ERODEFACTOR moves only what it would in the part of the
+  //    timestep that erodes ERODEFACTOR, so the sweep runs once.
+  if (erode_timestep_type == 0)
+  {
+    time_factor = time_factor * 1.5;
+  }
   
   do
   {
   tempbmax = 0;
-#pragma omp parallel for reduction(max:tempbmax) \
-//  private(tempdir, temp_dist, temptot2, veltot, vel, qtot, tau, velnum, slopetot) schedule(runtime)
-    for (unsigned int y = 1; y < jmax; ++y) 
+#pragma omp parallel for reduction(max:tempbmax) schedule(dynamic)
+    for (unsigned int s = 0; s < wet_spans.size(); ++s)
     {
-      int inc = 1;
-      while (down_scan[y][inc] > 0)
+      const unsigned x = wet_spans[s].x;
+      for (int inc = wet_spans[s].first; inc < wet_spans[s].last; ++inc)
       {
-        unsigned x = down_scan[y][inc];
-        inc++;
+        unsigned y = down_scan[x][inc];
+        if (y >= jmax) break;
         
         
         // zero vels.
@@ -3363,15 +3675,15 @@ double LSDCatchmentModel::erode(double mult_factor)
             int y2 = y + deltaY[p];
             if (water_depth[x2][y2] > water_depth_erosion_threshold)
             {
-              if (edge[x][y] > edge[x2][y2])
+              if (lateral && edge[x][y] > edge[x2][y2])
               {
                 temptot2 += (edge[x][y] - edge[x2][y2]);
               }
               
-              if (vel_dir[x][y][p] > 0 )
+              if (vel_dir(x, y, p) > 0 )
               {
                 // first work out velocities in each direction (for sedi distribution)
-                vel = vel_dir[x][y][p];
+                vel = vel_dir(x, y, p);
                 if (vel > max_vel)
                 {
                   vel = max_vel; // if vel too high cut it
@@ -3523,7 +3835,7 @@ double LSDCatchmentModel::erode(double mult_factor)
             
             // veg components
             // here to erode the veg layer..
-            if (veg[x][y][1] > 0 && tau > vegTauCrit)
+            if (vegetation_on && veg[x][y][1] > 0 && tau > vegTauCrit)
             {
               // now to remove from veg layer..
               veg[x][y][1] -= mult_factor * time_factor * std::pow(tau - vegTauCrit, 0.5) * 0.00001;
@@ -3531,7 +3843,7 @@ double LSDCatchmentModel::erode(double mult_factor)
             }
             
             // now to determine if movement should be restricted due to veg... or because of bedrock...
-            if (veg[x][y][1] > 0.25)
+            if (vegetation_on && veg[x][y][1] > 0.25)
             {
               // now checks if this removed from the cell would put it below the veg layer..
               if (elev[x][y] - temptot1 <= veg[x][y][0])
@@ -3554,6 +3866,16 @@ double LSDCatchmentModel::erode(double mult_factor)
               }
             }
             
+            if (erode_timestep_type == 1 && temptot1 > ERODEFACTOR)
+            {
+              double local_factor = ERODEFACTOR / temptot1;
+              for (unsigned n = 1; n <= G_MAX-1; n++)
+              {
+                temp_dist[n] *= local_factor;
+              }
+              temptot1 = ERODEFACTOR;
+            }
+            
             if (temptot1 > tempbmax) 
             {
               tempbmax = temptot1;
@@ -3574,12 +3896,12 @@ double LSDCatchmentModel::erode(double mult_factor)
                   double factor = 0;
                   
                   // vel slope
-                  if (vel_dir[x][y][p] > 0)
+                  if (vel_dir(x, y, p) > 0)
                   {
                     factor += 0.75 * tempdir[p] / veltot;
                   }
                   // now for lateral gradient.
-                  if (edge[x][y] > edge[x2][y2])
+                  if (lateral && edge[x][y] > edge[x2][y2])
                   {
                     factor += 0.25 * ((edge[x][y] - edge[x2][y2]) / temptot2);
                   }
@@ -3614,148 +3936,147 @@ double LSDCatchmentModel::erode(double mult_factor)
       }
     }
     
-    if (tempbmax > ERODEFACTOR)
+    if (erode_timestep_type == 0 && tempbmax > ERODEFACTOR)
     {
       time_factor *= (ERODEFACTOR / tempbmax) * 0.5;
     }
-//      switch (erode_timestep_type)
-//      {
-//        case 0:
-//          time_factor *= (ERODEFACTOR / tempbmax) * 0.5;
-//          local_time_factor = time_factor;
-//          break;
-//        case 1:
-//          local_time_factor *= (ERODEFACTOR / tempbmax) * 0.5;
-//          break;
-//      }
-//    }
-  } while(tempbmax > ERODEFACTOR);
+  } while(erode_timestep_type == 0 && tempbmax > ERODEFACTOR);
   
-  TNT::Array2D<double> erodetot(imax+2, jmax+2, 0.0);
-  TNT::Array2D<double> erodetot3(imax+2, jmax+2, 0.0);
+  LSDGrid<double> erodetot(imax+2, jmax+2, 0.0);
+  LSDGrid<double> erodetot3(imax+2, jmax+2, 0.0);
   
-#pragma omp parallel for
-  for (unsigned y = 2; y < jmax; ++y)
+// The lateral erosion in this loop takes sediment from the rows either
+// side, so only rows three apart are updated at the same time
+  for (unsigned colour = 0; colour < 3; colour++)
   {
-    int inc = 1;
-    while (down_scan[y][inc] > 0)
+#pragma omp parallel for schedule(dynamic)
+    for (unsigned s = 0; s < wet_spans.size(); ++s)
     {
-      unsigned x = down_scan[y][inc];
-      inc++;
-      
-      if (water_depth[x][y] > water_depth_erosion_threshold && x < imax && x > 1)
+      const unsigned x = wet_spans[s].x;
+      if (x % 3 != colour) continue;
+      for (int inc = wet_spans[s].first; inc < wet_spans[s].last; ++inc)
       {
-        if (index[x][y] == -9999) addGS(x, y);
-        for (unsigned int n = 1; n <= G_MAX-1; n++)
+        unsigned y = down_scan[x][inc];
+        if (y >= jmax) break;
+        if (y < 2) continue;
+      
+        if (water_depth[x][y] > water_depth_erosion_threshold && x < imax && x > 1)
         {
-          if (n == 1 && isSuspended[n])
+          if (index[x][y] == -9999) addGS(x, y);
+          for (unsigned int n = 1; n <= G_MAX-1; n++)
           {
-            // updating entrainment of SS
-            Vsusptot[x][y] += ss[x][y];
-            grain[index[x][y]][n] -= ss[x][y];
-            erodetot[x][y] -= ss[x][y];
+            if (n == 1 && isSuspended[n])
+            {
+              // updating entrainment of SS
+              Vsusptot[x][y] += ss[x][y];
+              grain[index[x][y]][n] -= ss[x][y];
+              erodetot[x][y] -= ss[x][y];
             
-            // this next part is unusual. You have to stop susp sed deposition on the input cells, otherwies
-            // it drops sediment out, but cannot entrain as ss levels in input are too high leading to
-            // little mountains of sediment. This means a new array in order to check whether a cell is an 
-            // input point or not..
-            if (!inputpointsarray[x][y])
+              // this next part is unusual. You have to stop susp sed deposition on the input cells, otherwies
+              // it drops sediment out, but cannot entrain as ss levels in input are too high leading to
+              // little mountains of sediment. This means a new array in order to check whether a cell is an 
+              // input point or not..
+              if (!inputpointsarray[x][y])
+              {
+                // now calc ss to be dropped
+                double coeff = (fallVelocity[n] * time_factor) / water_depth[x][y];
+                if (coeff > 1) coeff = 1;
+                double Vpdrop = coeff * Vsusptot[x][y];
+                if (Vpdrop > 0.001) Vpdrop = 0.001; //only allow 1mm to be deposited per iteration
+                grain[index[x][y]][n] += Vpdrop;
+                erodetot[x][y] += Vpdrop;
+                Vsusptot[x][y] -= Vpdrop;
+                //if (Vsusptot[x][y] < 0) Vsusptot[x][y] = 0; NOT this line.
+              }
+            }
+            else
             {
-              // now calc ss to be dropped
-              double coeff = (fallVelocity[n] * time_factor) / water_depth[x][y];
-              if (coeff > 1) coeff = 1;
-              double Vpdrop = coeff * Vsusptot[x][y];
-              if (Vpdrop > 0.001) Vpdrop = 0.001; //only allow 1mm to be deposited per iteration
-              grain[index[x][y]][n] += Vpdrop;
-              erodetot[x][y] += Vpdrop;
-              Vsusptot[x][y] -= Vpdrop;
-              //if (Vsusptot[x][y] < 0) Vsusptot[x][y] = 0; NOT this line.
+              //else update grain and elevations for bedload.
+              double val1 = (su[x][y][n] + sr[x][y][n] + sd[x][y][n] + sl[x][y][n]);
+              double val2 = (su[x][y + 1][n] + sd[x][y - 1][n] + sl[x + 1][y][n] + sr[x - 1][y][n]);
+              grain[index[x][y]][n] += val2 - val1;
+              erodetot[x][y] += val2 - val1;
+              erodetot3[x][y] += val1;
             }
           }
-          else
-          {
-            //else update grain and elevations for bedload.
-            double val1 = (su[x][y][n] + sr[x][y][n] + sd[x][y][n] + sl[x][y][n]);
-            double val2 = (su[x][y + 1][n] + sd[x][y - 1][n] + sl[x + 1][y][n] + sr[x - 1][y][n]);
-            grain[index[x][y]][n] += val2 - val1;
-            erodetot[x][y] += val2 - val1;
-            erodetot3[x][y] += val1;
-          }
-        }
         
-        elev[x][y] += erodetot[x][y];
-        if (erodetot[x][y] < 0) 
-        {
-          sort_active(x, y);
-        }
-        //
-        // test lateral code...
-        //
-        
-        if (erodetot3[x][y] > 0)
-        {
-          double elev_update = 0;
-          
-          if (elev[x - 1][y] > elev[x][y] && x > 2)
+          elev[x][y] += erodetot[x][y];
+          if (erodetot[x][y] < 0) 
           {
-            double amt = 0;
-            
-            if (water_depth[x - 1][y] < water_depth_erosion_threshold)
-            {
-              amt = mult_factor * lateral_constant * Tau[x][y] * edge[x - 1][y] * time_factor /DX;
-            }
-            else 
-            {
-              amt = chann_lateral_erosion * erodetot3[x][y] * (elev[x - 1][y] - elev[x][y]) / DX * 0.1;
-            }
-            if (amt > 0)
-            {
-              amt *= 1 - (veg[x - 1][y][1] * (1 - veg_lat_restriction));
-              if ((elev[x - 1][y] - amt) < bedrock[x - 1][y] || x - 1 == 1) amt = 0;
-              if (amt > ERODEFACTOR * 0.1) amt = ERODEFACTOR * 0.1;
-              //if (amt > erodetot2 / 2) amt = erodetot2 / 2;
-              elev_update += amt;
-              elev[x - 1][y] -= amt;
-              slide_GS(x - 1, y, amt, x, y);
-            }
+            sort_active(x, y);
           }
-          if (elev[x + 1][y] > elev[x][y] && x < imax-1)
+          //
+          // test lateral code...
+          //
+        
+          if (erodetot3[x][y] > 0)
           {
-            double amt = 0; 
-            if (water_depth[x + 1][y] < water_depth_erosion_threshold)
-            {
-              amt = mult_factor * lateral_constant * Tau[x][y] * edge[x + 1][y] * time_factor / DX;
-            }
-            else 
+            double elev_update = 0;
+          
+            if (elev[x - 1][y] > elev[x][y] && x > 2)
             {
-              amt = chann_lateral_erosion * erodetot3[x][y] * (elev[x + 1][y] - elev[x][y]) / DX * 0.1;
+              double amt = 0;
+            
+              if (water_depth[x - 1][y] < water_depth_erosion_threshold)
+              {
+                if (lateral) amt = mult_factor * lateral_constant * Tau[x][y] * edge[x - 1][y] * time_factor /DX;
+              }
+              else 
+              {
+                amt = chann_lateral_erosion * erodetot3[x][y] * (elev[x - 1][y] - elev[x][y]) / DX * 0.1;
+              }
+              if (amt > 0)
+              {
+                if (vegetation_on) amt *= 1 - (veg[x - 1][y][1] * (1 - veg_lat_restriction));
+                if ((elev[x - 1][y] - amt) < bedrock[x - 1][y] || x - 1 == 1) amt = 0;
+                if (amt > ERODEFACTOR * 0.1) amt = ERODEFACTOR * 0.1;
+                //if (amt > erodetot2 / 2) amt = erodetot2 / 2;
+                elev_update += amt;
+                elev[x - 1][y] -= amt;
+                slide_GS(x - 1, y, amt, x, y);
+              }
             }
-            if (amt > 0)
+            if (elev[x + 1][y] > elev[x][y] && x < imax-1)
             {
-              amt *= 1 - (veg[x + 1][y][1] * (1 - veg_lat_restriction));
-              if ((elev[x + 1][y] - amt) < bedrock[x + 1][y] || x + 1 == imax) amt = 0;
-              if (amt > ERODEFACTOR * 0.1) amt = ERODEFACTOR * 0.1;
-              //if (amt > erodetot2 /2) amt = erodetot2 /2;
-              elev_update += amt;
-              elev[x + 1][y] -= amt;
-              slide_GS(x + 1, y, amt, x, y);
+              double amt = 0; 
+              if (water_depth[x + 1][y] < water_depth_erosion_threshold)
+              {
+                if (lateral) amt = mult_factor * lateral_constant * Tau[x][y] * edge[x + 1][y] * time_factor / DX;
+              }
+              else 
+              {
+                amt = chann_lateral_erosion * erodetot3[x][y] * (elev[x + 1][y] - elev[x][y]) / DX * 0.1;
+              }
+              if (amt > 0)
+              {
+                if (vegetation_on) amt *= 1 - (veg[x + 1][y][1] * (1 - veg_lat_restriction));
+                if ((elev[x + 1][y] - amt) < bedrock[x + 1][y] || x + 1 == imax) amt = 0;
+                if (amt > ERODEFACTOR * 0.1) amt = ERODEFACTOR * 0.1;
+                //if (amt > erodetot2 /2) amt = erodetot2 /2;
+                elev_update += amt;
+                elev[x + 1][y] -= amt;
+                slide_GS(x + 1, y, amt, x, y);
+              }
             }
-          }
           
-          elev[x][y] += elev_update;
+            elev[x][y] += elev_update;
+          }
         }
       }
     }
   }
   
-#pragma omp parallel for 
-  for (unsigned y = 2; y < jmax; ++y)
+// This one takes sediment from the cells either side in the same row,
+// so each row is done by one thread
+#pragma omp parallel for schedule(dynamic)
+  for (unsigned x = 1; x <= imax; ++x)
   {
     int inc = 1;
-    while (down_scan[y][inc] > 0)
+    while (down_scan[x][inc] > 0 && down_scan[x][inc] < static_cast<int>(jmax))
     {
-      unsigned x = down_scan[y][inc];
+      unsigned y = down_scan[x][inc];
       inc++;
+      if (y < 2) continue;
       {
         if (erodetot3[x][y] > 0)
         {
@@ -3766,7 +4087,7 @@ double LSDCatchmentModel::erode(double mult_factor)
             double amt = 0;
             if (water_depth[x][y - 1] < water_depth_erosion_threshold)
             {
-              amt = mult_factor * lateral_constant * Tau[x][y] * edge[x][y - 1] * time_factor / DX;
+              if (lateral) amt = mult_factor * lateral_constant * Tau[x][y] * edge[x][y - 1] * time_factor / DX;
             }
             else
             {
@@ -3774,7 +4095,7 @@ double LSDCatchmentModel::erode(double mult_factor)
             }
             if (amt > 0)
             {
-              amt *= 1 - (veg[x][y - 1][1] * (1 - veg_lat_restriction));
+              if (vegetation_on) amt *= 1 - (veg[x][y - 1][1] * (1 - veg_lat_restriction));
               if ((elev[x][y - 1] - amt) < bedrock[x][y - 1] || y - 1 == 1) amt = 0;
               if (amt > ERODEFACTOR * 0.1) amt = ERODEFACTOR * 0.1;
               //if (amt > erodetot2 / 2) amt = erodetot2 / 2;
@@ -3788,7 +4109,7 @@ double LSDCatchmentModel::erode(double mult_factor)
             double amt = 0;
             if (water_depth[x][y + 1] < water_depth_erosion_threshold)
             {
-              amt = mult_factor * lateral_constant * Tau[x][y] * edge[x][y + 1] * time_factor / DX;
+              if (lateral) amt = mult_factor * lateral_constant * Tau[x][y] * edge[x][y + 1] * time_factor / DX;
             }
             else 
             {
@@ -3797,7 +4118,7 @@ double LSDCatchmentModel::erode(double mult_factor)
             
             if (amt > 0)
             {
-              amt *= 1 - (veg[x][y + 1][1] * (1 - veg_lat_restriction));
+              if (vegetation_on) amt *= 1 - (veg[x][y + 1][1] * (1 - veg_lat_restriction));
               if ((elev[x][y + 1] - amt) < bedrock[x][y + 1] || y + 1 == jmax) amt = 0;
               if (amt > ERODEFACTOR * 0.1) amt = ERODEFACTOR * 0.1;
               //if (amt > erodetot2 / 2) amt = erodetot2 / 2;
@@ -3822,7 +4143,7 @@ double LSDCatchmentModel::erode(double mult_factor)
 #endif
   for (unsigned y = 2; y < jmax; y++)
   {
-    if (water_depth[imax][y] > water_depth_erosion_threshold || Vsusptot[imax][y] > 0)
+    if (water_depth[imax][y] > water_depth_erosion_threshold || (suspended && Vsusptot[imax][y] > 0))
     {
       for (unsigned int n = 1; n <= G_MAX-1; n++)
       {
@@ -3837,7 +4158,7 @@ double LSDCatchmentModel::erode(double mult_factor)
         }
       }
     }
-    if (water_depth[1][y] > water_depth_erosion_threshold || Vsusptot[1][y] > 0)
+    if (water_depth[1][y] > water_depth_erosion_threshold || (suspended && Vsusptot[1][y] > 0))
     {
       for (unsigned int n = 1; n <= G_MAX-1; n++)
       {
@@ -3861,7 +4182,7 @@ double LSDCatchmentModel::erode(double mult_factor)
 #endif
   for (unsigned x = 2; x < imax; x++)
   {
-    if (water_depth[x][jmax] > water_depth_erosion_threshold || Vsusptot[x][jmax] > 0)
+    if (water_depth[x][jmax] > water_depth_erosion_threshold || (suspended && Vsusptot[x][jmax] > 0))
     {
       for (unsigned int n = 1; n <= G_MAX-1; n++)
       {
@@ -3876,7 +4197,7 @@ double LSDCatchmentModel::erode(double mult_factor)
         }
       }
     }
-    if (water_depth[x][1] > water_depth_erosion_threshold || Vsusptot[x][1] > 0)
+    if (water_depth[x][1] > water_depth_erosion_threshold || (suspended && Vsusptot[x][1] > 0))
     {
       for (unsigned int n = 1; n <= G_MAX-1; n++)
       {
@@ -3927,13 +4248,15 @@ void LSDCatchmentModel::lateral3()
 
   // first make water depth2 equal to water depth then remove single wet cells frmo water depth2 that have an undue influence..
   double mft = 0.1;// water_depth_erosion_threshold;//MIN_Q;// vel_dir threshold
-  for (unsigned y = 2; y < jmax; y++)   // fix dav 2016 - should it start from 1 though?
+  for (unsigned row = 1; row <= imax; row++)   // fix dav 2016 - should it start from 1 though?
   {
 
     int inc = 1;
-    while (down_scan[y][inc] > 0)
+    while (down_scan[row][inc] > 0 && down_scan[row][inc] < static_cast<int>(jmax))
     {
-      unsigned x = down_scan[y][inc];
+      unsigned x = row;
+      unsigned y = down_scan[row][inc];
+      if (y < 2) { inc++; continue; }
 
       edge_temp[x][y] = 0;
       if (x == 1) x++;
@@ -4078,12 +4401,14 @@ void LSDCatchmentModel::lateral3()
   for (int n = 1; n <= edge_smoothing_passes+downstream_shift; n++)
   {
     #pragma omp parallel for
-    for (unsigned y=2; y<imax; y++)
+    for (unsigned row = 1; row <= imax; row++)
     {
       int inc = 1;
-      while (down_scan[y][inc] > 0)
+      while (down_scan[row][inc] > 0 && down_scan[row][inc] < static_cast<int>(imax))
       {
-        unsigned x = down_scan[y][inc];
+        unsigned x = row;
+        unsigned y = down_scan[row][inc];
+        if (y < 2) { inc++; continue; }
 
         edge_temp[x][y] = 0;
         if (x == 1) x++;
@@ -4257,12 +4582,14 @@ void LSDCatchmentModel::lateral3()
       }
     }
 
-    for (unsigned y = 2; y < imax; y++)
+    for (unsigned row = 1; row <= imax; row++)
     {
       int inc = 1;
-      while (down_scan[y][inc] > 0)
+      while (down_scan[row][inc] > 0 && down_scan[row][inc] < static_cast<int>(imax))
       {
-        unsigned x = down_scan[y][inc];
+        unsigned x = row;
+        unsigned y = down_scan[row][inc];
+        if (y < 2) { inc++; continue; }
         //if (x == 1) x++;
         //if (x == jmax) x--;
         inc++;
@@ -4300,12 +4627,14 @@ void LSDCatchmentModel::lateral3()
   {
     counter++;
     // Parallelise outer loop
-    for (unsigned y = 2; y < imax; y++)
+    for (unsigned row = 1; row <= imax; row++)
     {
       int inc = 1;
-      while (down_scan[y][inc] > 0)
+      while (down_scan[row][inc] > 0 && down_scan[row][inc] < static_cast<int>(imax))
       {
-        unsigned x = down_scan[y][inc];
+        unsigned x = row;
+        unsigned y = down_scan[row][inc];
+        if (y < 2) { inc++; continue; }
 
         edge_temp[x][y] = 0;
         if (x == 1) x++;
@@ -4336,12 +4665,14 @@ void LSDCatchmentModel::lateral3()
     }
 
     tempdiff = 0;
-    for (unsigned y = 2; y < imax; y++)
+    for (unsigned row = 1; row <= imax; row++)
     {
       int inc = 1;
-      while (down_scan[y][inc] > 0)
+      while (down_scan[row][inc] > 0 && down_scan[row][inc] < static_cast<int>(imax))
       {
-        unsigned x = down_scan[y][inc];
+        unsigned x = row;
+        unsigned y = down_scan[row][inc];
+        if (y < 2) { inc++; continue; }
         if (x == 1) x++;
         if (x == jmax) x--;
         inc++;
@@ -4500,14 +4831,16 @@ void LSDCatchmentModel::slide_3()
   double factor=std::tan((failureangle*(3.141592654/180)))*DX;
   double diff=0;
 
-  for(y=2;y<jmax;y++)
+  for(unsigned row=1;row<=imax;row++)
   {
 
     inc=1;
-    while(down_scan[y][inc]>0)
+    while(down_scan[row][inc]>0&&down_scan[row][inc]<static_cast<int>(jmax))
     {
 
-      x=down_scan[y][inc];
+      x=row;
+      y=down_scan[row][inc];
+      if(y<2){inc++;continue;}
       if(x==imax)x=imax-1;
       if(x==1)x=2;
 
@@ -4728,6 +5061,8 @@ void LSDCatchmentModel::soil_erosion(double time)
   unsigned x, y;
   double temp;
 
+  // The drainage area has to follow the elevations
+  zero_and_calc_drainage_area();
 
   for (x = 1; x <= jmax; x++)
   {
@@ -4856,6 +5191,8 @@ void LSDCatchmentModel::soil_erosion(double time)
 // all based on Van Walleghem et al., 2013 (JGR:ES)
 void LSDCatchmentModel::soil_development()
 {
+  LSDStrata& strata = grain.get_strata();
+
   for (unsigned x = 1; x <= imax; x++)
   {
     for (unsigned y = 1; y <= jmax; y++)
@@ -4914,17 +5251,17 @@ void LSDCatchmentModel::soil_development()
               for (int z = 1; z <= 9; z++)
               {
                 // What is this actually needed for? check original implementation
-                double amount2 = strata[xyindex][z - 1][n] * ((-(k1 * std::exp(-c1 * active * z) * (c2 / std::log(Di * 0.001)) * 1)) / 12); //  / 12 to make it months
+                double amount2 = strata.layer(xyindex, z - 1)[n] * ((-(k1 * std::exp(-c1 * active * z) * (c2 / std::log(Di * 0.001)) * 1)) / 12); //  / 12 to make it months
 
-                strata[xyindex][z-1][n] -= amount;
+                strata.layer(xyindex, z-1)[n] -= amount;
                 if (n == 2)
                 {
-                  strata[xyindex][z-1][n - 1] += amount;
+                  strata.layer(xyindex, z-1)[n - 1] += amount;
                 }
                 else
                 {
-                  strata[xyindex][z-1][n - 1] += amount * 0.05;
-                  strata[xyindex][z-1][n - 2] += amount * 0.95;
+                  strata.layer(xyindex, z-1)[n - 1] += amount * 0.05;
+                  strata.layer(xyindex, z-1)[n - 2] += amount * 0.95;
                 }
               }
             }
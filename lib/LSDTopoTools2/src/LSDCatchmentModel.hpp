@@ -3,6 +3,7 @@
 // Header file for the LSDCatchmentModel
 
 #include <vector>
+#include <algorithm>
 #include <cmath>
 #include <string>
 #include <array>
@@ -20,6 +21,9 @@
 #include "LSDGrainMatrix.hpp"
 #include "LSDStatsTools.hpp"
 #include "LSDRainfallRunoff.hpp"
+#include "LSDGrid.hpp"
+#include "LSDGrainPool.hpp"
+#include "LSDFaceVelocities.hpp"
 
 #include "TNT/tnt.h"   // Template Numerical Toolkit library: used for 2D Arrays.
 
@@ -159,6 +163,10 @@ public:
   /// @details also sets 'hard-coded' parameters to start the model
   void initialise_arrays();
 
+  /// @brief Prints how much memory the grids allocated by
+  /// initialise_arrays() take
+  void print_memory_report();
+
   /// @brief Wrapper function that calls the main erosion method
   /// @return
   void call_erosion();
@@ -213,6 +221,10 @@ public:
   /// @author Translated by DAV
   void drainage_area_D8();
 
+  /// @brief Sorts the cells into drainage_order, unless the elevations
+  /// are still in the order of the last call
+  void update_drainage_order();
+
   void get_catchment_input_points();
   
   void get_catchment_input_points(runoffGrid& runoff);
@@ -236,6 +248,10 @@ public:
 
   void sort_active(int x,int y);
 
+  /// Moves layers between the active layer of a grain size record and
+  /// its strata, as sort_active, for a record given by number
+  void sort_active_record(int xyindex);
+
   double d50(int index1);
 
   double sand_fraction(int index1);
@@ -298,6 +314,10 @@ public:
   /// object.
   void catchment_water_input_and_hydrology( double local_time_factor, runoffGrid& runoff);
 
+  /// Adds the runoff of row i of the runoff grid to the water depths.
+  /// @return the water input of the row
+  double add_runoff_to_row(int i, double local_time_factor, const runoffGrid& runoff);
+
   /// Calculates the amount of water entering grid cells from the rainfall timeseries
   /// and hydroindex if spatially variable rainfall is used.
   /// @details Based on the semi-dsitributed TOPMODEL rainfall runoff model
@@ -317,8 +337,16 @@ public:
 
   void evaporate(double time);
 
+  /// Updates the list of wet cells (down_scan) incrementally: only the
+  /// cells already listed and the water input points are looked at.
   void scan_area();
 
+  /// Rebuilds the list of wet cells from the whole grid
+  void rescan_area();
+
+  /// Cuts the lists of wet cells into wet_spans of about equal length
+  void split_wet_spans();
+
   void water_flux_out();
   
   /// Counts the number of cells within the catchment boundary. For
@@ -339,6 +367,31 @@ public:
   double get_cycle() const { return cycle; }
   int get_maxcycle() const { return maxcycle; }
   bool is_hydro_only() const { return hydro_only; }
+
+  /// @return true if a grain size fraction is carried in suspension;
+  /// qxs, qys and Vsusptot are only allocated if so
+  bool suspended_sediment_on() const
+    { return std::find(isSuspended.begin(), isSuspended.end(), true) != isSuspended.end(); }
+
+  /// @brief Access to the hydrological state and parameters, so that the
+  /// model can be driven step by step and compared against another
+  /// implementation (e.g. a parallel port).
+  /// Arrays are indexed [x][y] with x in 1..imax, y in 1..jmax and a
+  /// border of one cell on each side.
+  LSDGrid<double>& get_elev() { return elev; }
+  LSDGrid<double>& get_water_depth() { return water_depth; }
+  LSDGrid<double>& get_qx() { return qx; }
+  LSDGrid<double>& get_qy() { return qy; }
+  double get_DX() const { return DX; }
+  double get_no_data_value() const { return no_data_value; }
+  double get_edgeslope() const { return edgeslope; }
+  double get_hflow_threshold() const { return hflow_threshold; }
+  double get_courant_number() const { return courant_number; }
+  double get_mannings() const { return mannings; }
+  double get_froude_limit() const { return froude_limit; }
+  double get_water_depth_erosion_threshold() const { return water_depth_erosion_threshold; }
+  double get_maxdepth() const { return maxdepth; }
+  void set_time_factor(double new_time_factor) { time_factor = new_time_factor; }
   
 private:
 
@@ -415,7 +468,6 @@ private:
   double CREEP_RATE=0.0025;
   double SOIL_RATE = 0.0025;
   double active=0.2;
-  int grain_array_tot =1 ;
 
   /// Number of passes for edge smoothing filter
   double edge_smoothing_passes = 100.0;
@@ -555,28 +607,51 @@ private:
   /// Water depth LSDRaster object
   /// LSDRaster water_depthR;
 
-  TNT::Array2D<double> elev;
-  TNT::Array2D<double> bedrock;
-  TNT::Array2D<double> init_elevs;
-  TNT::Array2D<double> water_depth;
-  TNT::Array2D<double> area;
-  TNT::Array2D<double> tempcreep;
-  TNT::Array2D<double> Tau;
-  TNT::Array2D<double> Vel;
-  TNT::Array2D<double> qx;
-  TNT::Array2D<double> qy;
-  TNT::Array2D<double> qxs;
-  TNT::Array2D<double> qys;
+  // The grids used by the hydrology and erosion loops are row-major
+  // LSDGrids indexed [x][y], so y is the contiguous index: loop over x
+  // outside and y inside. down_scan[x] lists the y of the wet cells of
+  // row x (see scan_area()), ending with a 0.
+  LSDGrid<double> elev;
+  LSDGrid<double> bedrock;
+  LSDGrid<double> init_elevs;
+  LSDGrid<double> water_depth;
+  LSDGrid<double> area;
+  LSDGrid<double> tempcreep;
+  LSDGrid<double> Tau;
+  LSDGrid<double> Vel;
+  LSDGrid<double> qx;
+  LSDGrid<double> qy;
+  LSDGrid<double> qxs;
+  LSDGrid<double> qys;
   /* dune arrays */
-  TNT::Array2D<double> area_depth;
+  LSDGrid<double> area_depth;
   TNT::Array2D<double> sand;
   TNT::Array2D<double> elev2;
   TNT::Array2D<double> sand2;
-  TNT::Array2D<double> grain;
-  TNT::Array2D<double> elev_diff;
+  LSDGrainPool grain;
 
   TNT::Array2D<int> index;
-  TNT::Array2D<int> down_scan;
+  LSDGrid<int> down_scan;
+  std::vector<int> down_scan_count; // length of the list of each row
+  LSDGrid<int> wet_scan; // scan_area() call at which a cell last had water in or next to it
+  int scan_number = 0; // scan_area() calls so far
+
+  /// @brief Part of the list of wet cells of one row:
+  /// down_scan[x][first] up to, but not including, down_scan[x][last]
+  struct WetSpan
+  {
+    unsigned x;
+    int first;
+    int last;
+  };
+  /// The wet cells in spans of about equal length, to share them out
+  /// evenly between threads however they are spread over the rows
+  std::vector<WetSpan> wet_spans;
+
+  /// The cells of the grid (x*(jmax+2)+y) from the highest to the
+  /// lowest, the order drainage_area_D8() works through them in. Kept
+  /// between calls, as erosion seldom changes it.
+  std::vector<int> drainage_order;
   TNT::Array2D<int> rfarea;
 
   TNT::Array2D<bool> inputpointsarray;
@@ -584,8 +659,9 @@ private:
   std::vector<int> catchment_input_x_coord;
   std::vector<int> catchment_input_y_coord;
 
-  TNT::Array3D<double> vel_dir;
-  TNT::Array3D<double> strata;
+  /// Velocity out of each cell across its faces, D8 directions 1, 3, 5
+  /// and 7 (written by flow_route, read by erode)
+  LSDFaceVelocities vel_dir;
 
   std::vector<double> hourly_m_value;
   std::vector<double> temp_grain;
@@ -599,7 +675,7 @@ private:
   // MJ global vars
   std::vector<double> fallVelocity;
   std::vector<bool> isSuspended;
-  TNT::Array2D<double> Vsusptot;
+  LSDGrid<double> Vsusptot;
 
 
   std::vector<int> nActualGridCells;
@@ -625,6 +701,10 @@ private:
   std::vector<int> catchment_input_counter;
   int totalinputpoints = 0;
 
+  /// Number of scan_area() calls a cell stays in down_scan after there
+  /// was last water in or next to it (0: dropped as soon as it dries)
+  int wet_area_dry_scans = 0;
+
   /// Soil generation variables
   double P1, b1, k1, c1, c2, k2, c3, c4;
 
@@ -651,8 +731,11 @@ private:
   bool graindata_from_file = false;
 
   bool spatially_complex_rainfall = false;
+  /// Sum the water input serially, in the original order, so that it does
+  /// not depend on the number of threads
+  bool deterministic_reductions = false;
   
-  int erode_timestep_type = 0;  // 0 for default based on erosion amount, 1 for basedon hydro timestep
+  int erode_timestep_type = 0;  // 0 for default based on erosion amount, 1 for local (per cell) erosion timestep
   int hydro_timestep_type = 0;  // 0 for default
 
   // Bools for writing out files
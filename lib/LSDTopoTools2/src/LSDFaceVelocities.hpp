@@ -0,0 +1,43 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDFaceVelocities
+// Land Surface Dynamics flow velocities across cell faces
+//
+// The velocity of the flow out of each cell across its four faces, in
+// the D8 directions 1 (north), 3 (east), 5 (south) and 7 (west) used
+// by LSDCatchmentModel. The diagonal directions never carry flow, so
+// only the four faces are stored, as floats, next to each other in an
+// LSDGrid: everything erode reads for a cell is in one 16 byte chunk.
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDFaceVelocities_H
+#define LSDFaceVelocities_H
+
+#include "LSDGrid.hpp"
+
+
+class LSDFaceVelocities
+{
+  public:
+  LSDFaceVelocities() {}
+
+  /// @brief Velocities for a grid of n_rows by n_cols cells, all zero
+  LSDFaceVelocities(int n_rows, int n_cols) : faces(n_rows, n_cols*4, 0.0f) {}
+
+  /// @return the velocity out of cell [row][col] in direction p, which
+  /// must be 1, 3, 5 or 7
+  float& operator()(int row, int col, int p) { return faces[row][col*4 + p/2]; }
+  float operator()(int row, int col, int p) const { return faces[row][col*4 + p/2]; }
+
+  /// @brief Sets every velocity to zero
+  void zero() { faces.fill(0.0f); }
+
+  /// @return the grid holding the four faces of each cell
+  const LSDGrid<float>& get_faces() const { return faces; }
+
+  private:
+  LSDGrid<float> faces;
+};
+
+#endif
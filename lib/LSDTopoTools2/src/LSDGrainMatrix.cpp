@@ -98,7 +98,7 @@ void LSDGrainMatrix::write_grainMatrix_to_ascii_file(std::string filename,
           {
             for(int inc=0; inc<=(GrainFracMax-2); inc++)
             {
-              data_out << strataData[rasterIndex[i][j]][z][inc] << " ";
+              data_out << strataData.layer(rasterIndex[i][j], z)[inc] << " ";
             }
           }
           data_out << std::endl;
@@ -25,6 +25,7 @@
 #include <fstream>
 #include <sstream>
 #include "TNT/tnt.h"
+#include "LSDGrainPool.hpp"
 
 #ifndef LSDGrainMatrix_H
 #define LSDGrainMatrix_H
@@ -51,9 +52,8 @@ public:
   /// Create a GrainMatrix object from references to arrays (in LSDCatchmentModel, though needn't be this object)
   LSDGrainMatrix( int imax, int jmax, int NoDataVal, int G_MAX,
                   TNT::Array2D<int>& indexes, 
-                  TNT::Array2D<double>& graindatas,
-                  TNT::Array3D<double>& stratadatas)
-    : rasterIndex(indexes), grainData(graindatas), strataData(stratadatas)
+                  LSDGrainPool& graindatas)
+    : rasterIndex(indexes), grainData(graindatas), strataData(graindatas.get_strata())
   {
     create(imax, jmax, NoDataVal, G_MAX);
   }
@@ -63,8 +63,8 @@ public:
   
 protected:
   TNT::Array2D<int>& rasterIndex;
-  TNT::Array2D<double>& grainData;
-  TNT::Array3D<double>& strataData;
+  LSDGrainPool& grainData;
+  LSDStrata& strataData;
   
   int NCols;
   int NRows;
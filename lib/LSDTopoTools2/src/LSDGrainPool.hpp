@@ -0,0 +1,158 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDGrainPool
+// Land Surface Dynamics grain size records
+//
+// The grain size records of LSDCatchmentModel: for each cell that has
+// one (index[x][y] != -9999), the fractions of the active layer and
+// the strata below it. Records are numbered from 1.
+//
+// Records are handed out by allocate, which any thread can call at
+// the same time without a lock, and a record a thread took but did not
+// use can be handed back with release. The records are stored in blocks of
+// LSDStrata::BlockSize; each thread takes a whole block at a time (one
+// atomic increment) and then hands out its records on its own. The
+// thread taking a block also allocates its storage, so memory grows
+// with the number of cells that have sediment, not the grid size.
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDGrainPool_H
+#define LSDGrainPool_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <omp.h>
+#include "LSDStrata.hpp"
+
+
+class LSDGrainPool
+{
+  public:
+  LSDGrainPool() : NClasses(0), NextBlock(0) {}
+
+  /// @brief Room for up to max_records records of n_classes grain size
+  /// classes, with n_layers strata layers. The fractions of new
+  /// records are set to value
+  LSDGrainPool(int max_records, int n_layers, int n_classes, double value = 0.0)
+    : NClasses(n_classes), Value(value),
+      // one spare block per thread: a thread's block may be part used
+      strata(max_records + 1 + omp_get_max_threads()*LSDStrata::BlockSize,
+             n_layers, n_classes, value),
+      blocks(strata.get_NBlocks()),
+      chunks(omp_get_max_threads()),
+      NextBlock(0)
+  {}
+
+  LSDGrainPool& operator=(LSDGrainPool&& other)
+  {
+    NClasses = other.NClasses;
+    Value = other.Value;
+    strata = std::move(other.strata);
+    blocks = std::move(other.blocks);
+    chunks = std::move(other.chunks);
+    NextBlock.store(other.NextBlock.load());
+    return *this;
+  }
+
+  /// @return the grain size fractions of the active layer of a record
+  double* operator[](int record)
+  {
+    return &blocks[record / LSDStrata::BlockSize][(record % LSDStrata::BlockSize)*NClasses];
+  }
+  const double* operator[](int record) const
+  {
+    return &blocks[record / LSDStrata::BlockSize][(record % LSDStrata::BlockSize)*NClasses];
+  }
+
+  /// @return the strata of the records, indexed by record
+  LSDStrata& get_strata() { return strata; }
+
+  /// @brief Takes a new record. Thread safe, without a lock.
+  /// @return the number of the record
+  int allocate()
+  {
+    const size_t thread = omp_get_thread_num();
+    if (thread >= chunks.size())
+    {
+      // more threads than when the pool was made: a block to itself
+      Chunk spare;
+      take_block(spare);
+      return spare.next;
+    }
+    Chunk& chunk = chunks[thread];
+    if (chunk.next == chunk.end)
+    {
+      take_block(chunk);
+    }
+    return chunk.next++;
+  }
+
+  /// @brief Hands back a record just taken by this thread and not used,
+  /// so that its next allocate returns it again. Any other record is
+  /// simply left unused.
+  void release(int record)
+  {
+    const size_t thread = omp_get_thread_num();
+    if (thread < chunks.size() && chunks[thread].next == record + 1)
+    {
+      chunks[thread].next--;
+    }
+  }
+
+  /// @return one more than the highest record number that may be in use
+  int get_NRecords() const
+  {
+    return NextBlock.load() * LSDStrata::BlockSize;
+  }
+
+  /// @brief Sets every fraction (active layer and strata) of the records
+  /// taken so far
+  void fill(double value)
+  {
+    for (size_t block = 0; block < blocks.size(); block++)
+    {
+      std::fill(blocks[block].begin(), blocks[block].end(), value);
+    }
+    strata.fill(value);
+  }
+
+  private:
+  /// The records of a block a thread hands out, padded to a cache line
+  /// so that threads do not share them
+  struct Chunk
+  {
+    int next = 0;
+    int end = 0;
+    char padding[64 - 2*sizeof(int)];
+  };
+
+  /// @brief Takes the next block for chunk and allocates its storage
+  void take_block(Chunk& chunk)
+  {
+    const int block = NextBlock.fetch_add(1);
+    if (block >= int(blocks.size()))
+    {
+      std::cout << "\nFATAL ERROR: LSDGrainPool has no room for more grain size records" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    blocks[block].assign(size_t(LSDStrata::BlockSize)*NClasses, Value);
+    strata.add_block(block);
+
+    // there is no record 0
+    chunk.next = std::max(block*LSDStrata::BlockSize, 1);
+    chunk.end = (block + 1)*LSDStrata::BlockSize;
+  }
+
+  int NClasses;
+  double Value = 0.0;
+  LSDStrata strata;
+  std::vector< std::vector<double> > blocks;
+  std::vector<Chunk> chunks;
+  std::atomic<int> NextBlock;
+};
+
+#endif
@@ -0,0 +1,155 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDGrid
+// Land Surface Dynamics contiguous grids
+//
+// A two dimensional array in one aligned block of memory, row-major,
+// with each row padded to a whole number of cache lines. Indexed
+// grid[row][col] like TNT::Array2D, but grid[row] is a plain pointer
+// into the block, so there is no row pointer table to go through and no
+// reference counting: copies are deep copies.
+//
+// The rows start on cache line boundaries, so a loop over the columns
+// of a row (the innermost index) walks memory contiguously and can be
+// vectorised. Loops should run over the rows outside and the columns
+// inside.
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDGrid_H
+#define LSDGrid_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include "TNT/tnt.h"
+
+
+template <class T>
+class LSDGrid
+{
+  public:
+  /// Bytes each row is aligned (and padded) to
+  static const size_t alignment = 64;
+
+  LSDGrid() : NRows(0), NCols(0), Stride(0), data(NULL) {}
+
+  /// @brief A grid of n_rows by n_cols, every element set to value
+  LSDGrid(int n_rows, int n_cols, T value = T()) : data(NULL)
+  {
+    allocate(n_rows, n_cols);
+    fill(value);
+  }
+
+  /// @brief A copy of a TNT array (e.g. the data of an LSDRaster)
+  explicit LSDGrid(const TNT::Array2D<T>& array) : data(NULL)
+  {
+    allocate(array.dim1(), array.dim2());
+    for (int row = 0; row < NRows; row++)
+    {
+      std::copy(array[row], array[row] + NCols, (*this)[row]);
+    }
+  }
+
+  LSDGrid(const LSDGrid& other) : data(NULL)
+  {
+    allocate(other.NRows, other.NCols);
+    std::copy(other.data, other.data + size_t(NRows)*Stride, data);
+  }
+
+  LSDGrid& operator=(const LSDGrid& other)
+  {
+    if (this != &other)
+    {
+      if (NRows != other.NRows || NCols != other.NCols)
+      {
+        free(data);
+        data = NULL;
+        allocate(other.NRows, other.NCols);
+      }
+      std::copy(other.data, other.data + size_t(NRows)*Stride, data);
+    }
+    return *this;
+  }
+
+  LSDGrid(LSDGrid&& other) : NRows(other.NRows), NCols(other.NCols), Stride(other.Stride), data(other.data)
+  {
+    other.NRows = other.NCols = 0;
+    other.Stride = 0;
+    other.data = NULL;
+  }
+
+  LSDGrid& operator=(LSDGrid&& other)
+  {
+    std::swap(NRows, other.NRows);
+    std::swap(NCols, other.NCols);
+    std::swap(Stride, other.Stride);
+    std::swap(data, other.data);
+    return *this;
+  }
+
+  ~LSDGrid()
+  {
+    free(data);
+  }
+
+  /// @return the start of a row; [col] on it gives the element
+  T* operator[](int row) { return data + size_t(row)*Stride; }
+  const T* operator[](int row) const { return data + size_t(row)*Stride; }
+
+  /// @return the number of rows
+  int dim1() const { return NRows; }
+
+  /// @return the number of columns
+  int dim2() const { return NCols; }
+
+  /// @return the distance between the starts of two rows, in elements
+  size_t get_stride() const { return Stride; }
+
+  /// @brief Sets every element, padding included
+  void fill(T value)
+  {
+    std::fill(data, data + size_t(NRows)*Stride, value);
+  }
+
+  /// @return a copy as a TNT array, e.g. to make an LSDRaster from it
+  TNT::Array2D<T> to_Array2D() const
+  {
+    TNT::Array2D<T> array(NRows, NCols);
+    for (int row = 0; row < NRows; row++)
+    {
+      std::copy((*this)[row], (*this)[row] + NCols, array[row]);
+    }
+    return array;
+  }
+
+  private:
+  void allocate(int n_rows, int n_cols)
+  {
+    const size_t per_line = alignment / sizeof(T);
+    NRows = n_rows;
+    NCols = n_cols;
+    Stride = ((size_t(n_cols) + per_line - 1) / per_line) * per_line;
+
+    void* block = NULL;
+    size_t bytes = std::max(size_t(NRows)*Stride*sizeof(T), alignment);
+    if (posix_memalign(&block, alignment, bytes) != 0)
+    {
+      std::cout << "\nFATAL ERROR: unable to allocate a grid of " << NRows
+                << " by " << NCols << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    data = static_cast<T*>(block);
+  }
+
+  int NRows;
+  int NCols;
+  size_t Stride;
+  T* data;
+};
+
+// std::max takes alignment by reference, so it needs a definition
+template <class T>
+const size_t LSDGrid<T>::alignment;
+
+#endif
@@ -95,6 +95,7 @@
 #include "LSDRaster.hpp"
 #include "LSDStatsTools.hpp"
 #include "LSDShapeTools.hpp"
+#include "LSDMappedFile.hpp"
 
 using namespace std;
 using namespace TNT;
@@ -110,6 +111,7 @@ LSDIndexRaster& LSDIndexRaster::operator=(const LSDIndexRaster& rhs)
     create(rhs.get_NRows(),rhs.get_NCols(),rhs.get_XMinimum(),rhs.get_YMinimum(),
            rhs.get_DataResolution(), rhs.get_NoDataValue(), rhs.get_RasterData(),
            rhs.get_GeoReferencingStrings() );
+    MappedData.reset();
    }
   return *this;
  }
@@ -131,6 +133,12 @@ void LSDIndexRaster::create(string filename, string extension)
 
 }
 
+// this creates a raster from a file mapped into memory
+void LSDIndexRaster::create(string filename, string extension, LSDMapMode map_mode)
+{
+  read_raster_mapped(filename,extension,map_mode);
+}
+
 // this creates a raster filled with the data in data
 // SMM 2012
 void LSDIndexRaster::create(int nrows, int ncols, float xmin, float ymin,
@@ -749,7 +757,72 @@ void LSDIndexRaster::read_raster(string filename, string extension)
     exit(EXIT_FAILURE);
   }
 
+  // the data are now on the heap
+  MappedData.reset();
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// read_raster_mapped
+// Reads a bil raster of 32 bit integers by mapping the data file into
+// memory, and points RasterData straight at the mapped data. Anything
+// that needs converting is read with read_raster instead.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+void LSDIndexRaster::read_raster_mapped(string filename, string extension, LSDMapMode mode)
+{
+  string string_filename = filename+"."+extension;
+  LSDBinaryRasterHeader header = read_binary_raster_header(filename, extension);
 
+  // flt files hold floats, which are converted to int
+  if (extension != "bil" || header.DataType != 3 || !header.NativeByteOrder
+      || header.HeaderOffset % sizeof(int) != 0)
+  {
+    cout << "Cannot map " << string_filename << " into memory (data type "
+         << header.DataType << ", native byte order " << header.NativeByteOrder
+         << ", header offset " << header.HeaderOffset << "), reading it instead" << endl;
+    read_raster(filename, extension);
+    return;
+  }
+
+  std::shared_ptr<LSDMappedFile> mapped(new LSDMappedFile(string_filename, mode));
+  size_t NData = size_t(header.NRows)*size_t(header.NCols);
+  if (mapped->get_size() < header.HeaderOffset + NData*sizeof(int))
+  {
+    cout << "\nFATAL ERROR: the data file \"" << string_filename << "\" is "
+         << mapped->get_size() << " bytes, expected at least "
+         << header.HeaderOffset + NData*sizeof(int) << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  NRows = header.NRows;
+  NCols = header.NCols;
+  XMinimum = header.XMinimum;
+  YMinimum = header.YMinimum;
+  DataResolution = header.DataResolution;
+  NoDataValue = int(header.NoDataValue);
+  GeoReferencingStrings = header.GeoReferencingStrings;
+
+  // TNT wraps data it has not allocated without taking ownership;
+  // MappedData keeps the mapping alive for as long as this raster
+  int* data = reinterpret_cast<int*>(mapped->get_data() + header.HeaderOffset);
+  RasterData = Array2D<int>(NRows, NCols, data);
+  MappedData = mapped;
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Moves the raster data onto the heap before the file they are mapped
+// from is overwritten: truncating a mapped file invalidates the mapping.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+void LSDIndexRaster::detach_mapped_file(string data_filename)
+{
+  if (MappedData && MappedData->is_same_file(data_filename))
+  {
+    RasterData = RasterData.copy();
+    MappedData.reset();
+  }
 }
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 
@@ -817,6 +890,7 @@ void LSDIndexRaster::write_raster(string filename, string extension)
     header_ofs.close();
 
     // now do the main data
+    detach_mapped_file(string_filename);
     ofstream data_ofs(string_filename.c_str(), ios::out | ios::binary);
     float temp;
     for (int i=0; i<NRows; ++i)
@@ -896,6 +970,7 @@ void LSDIndexRaster::write_raster(string filename, string extension)
     header_ofs.close();
 
     // now do the main data
+    detach_mapped_file(string_filename);
     ofstream data_ofs(string_filename.c_str(), ios::out | ios::binary);
 
     for (int i=0; i<NRows; ++i)
@@ -77,8 +77,10 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include "TNT/tnt.h"
 #include "LSDShapeTools.hpp"
+#include "LSDMappedFile.hpp"
 //#include "LSDRaster.hpp"
 
 using namespace std;
@@ -113,6 +115,14 @@ class LSDIndexRaster
   /// @date 01/01/12
   LSDIndexRaster(string filename, string extension)  { create(filename, extension); }
 
+  /// @brief Create an LSDIndexRaster from a .bil file mapped into memory.
+  /// @details See read_raster_mapped.
+  /// @param filename A String, the file to be loaded.
+  /// @param extension A String, the file extension to be loaded (flt or bil).
+  /// @param map_mode map_read_only or map_copy_on_write
+  LSDIndexRaster(string filename, string extension, LSDMapMode map_mode)
+      { create(filename, extension, map_mode); }
+
   /// @brief Create an LSDIndexRaster from memory.
   /// @return LSDIndexRaster
   /// @param nrows An integer of the number of rows.
@@ -193,8 +203,10 @@ class LSDIndexRaster
   float get_DataResolution() const           { return DataResolution; }
   /// @return No Data Value as an integer.
   int get_NoDataValue() const           { return NoDataValue; }
-  /// @return Raster values as a 2D Array.
-  Array2D<int> get_RasterData() const { return RasterData; }
+  /// @return Raster values as a 2D Array. TNT copies are shallow, so for a
+  /// memory mapped raster this is a deep copy: a view of the mapping would
+  /// dangle once the raster is gone.
+  Array2D<int> get_RasterData() const { return MappedData ? RasterData.copy() : RasterData; }
   /// @return Map of strings containing georeferencing information
   map<string,string> get_GeoReferencingStrings() const { return GeoReferencingStrings; }
 
@@ -221,6 +233,23 @@ class LSDIndexRaster
   /// @date 01/01/12
   void read_raster(string filename, string extension);
 
+  /// @brief Read a raster by mapping its data file into memory.
+  ///
+  /// As LSDRaster::read_raster_mapped: the data are used in place, from
+  /// the page cache, and the file is never changed. This needs 32 bit
+  /// integer data (ENVI data type 3) in the byte order of this machine;
+  /// .flt files and other data types are converted, so they are read
+  /// onto the heap with read_raster instead.
+  ///
+  /// @param filename a string of the filename _without_ the extension.
+  /// @param extension flt or bil
+  /// @param mode map_read_only or map_copy_on_write
+  void read_raster_mapped(string filename, string extension,
+                          LSDMapMode mode = map_copy_on_write);
+
+  /// @return true if the raster data are a file mapped into memory
+  bool is_memory_mapped() const { return bool(MappedData); }
+
   /// @brief Return the list of value but check if it has been initialized
   /// @author BG
   /// @date 19/09/2017
@@ -648,9 +677,14 @@ class LSDIndexRaster
   /// Raster data.
   Array2D<int> RasterData;
 
+  /// The mapped file RasterData points into, if read with read_raster_mapped.
+  /// Shared so that the mapping outlives shallow copies of RasterData.
+  std::shared_ptr<LSDMappedFile> MappedData;
+
   private:
   void create();
   void create(string filename, string extension);
+  void create(string filename, string extension, LSDMapMode map_mode);
   void create(int ncols, int nrows, float xmin, float ymin,
               float cellsize, int ndv, Array2D<int> data);
   void create(int ncols, int nrows, float xmin, float ymin,
@@ -661,6 +695,8 @@ class LSDIndexRaster
               int ConstValue);
   void create(LSDRaster& NonIntLSDRaster);
   void create(LSDRaster& ARaster, int ConstValue);
+
+  void detach_mapped_file(string data_filename);
 };
 
 #endif
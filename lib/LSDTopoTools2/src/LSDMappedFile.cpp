@@ -0,0 +1,314 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDMappedFile
+// Land Surface Dynamics memory mapped files
+//
+// Maps the binary raster formats (.flt and .bil) into memory so that
+// LSDRaster and LSDIndexRaster can use their data in place, through the
+// page cache, instead of copying them onto the heap.
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <cstdlib>
+#include <cctype>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "LSDMappedFile.hpp"
+using namespace std;
+
+#ifndef LSDMappedFile_CPP
+#define LSDMappedFile_CPP
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Maps a whole file. Read only mappings are shared, so all processes
+// reading the same raster use the same physical pages; copy on write
+// mappings are private, so writing to them never reaches the file.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+LSDMappedFile::LSDMappedFile(string fname, LSDMapMode mode)
+{
+  filename = fname;
+  data = NULL;
+  size = 0;
+
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    cout << "\nFATAL ERROR: the data file \"" << filename
+         << "\" doesn't exist" << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  struct stat file_info;
+  if (fstat(fd, &file_info) != 0)
+  {
+    cout << "\nFATAL ERROR: unable to get the size of \"" << filename
+         << "\": " << strerror(errno) << endl;
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+  size = size_t(file_info.st_size);
+  device = (unsigned long)file_info.st_dev;
+  inode = (unsigned long)file_info.st_ino;
+
+  if (size > 0)
+  {
+    int prot = PROT_READ;
+    int flags = MAP_SHARED;
+    if (mode == map_copy_on_write)
+    {
+      prot = PROT_READ | PROT_WRITE;
+      flags = MAP_PRIVATE;
+    }
+
+    void* mapped = mmap(NULL, size, prot, flags, fd, 0);
+    if (mapped == MAP_FAILED)
+    {
+      cout << "\nFATAL ERROR: unable to map \"" << filename
+           << "\" into memory: " << strerror(errno) << endl;
+      close(fd);
+      exit(EXIT_FAILURE);
+    }
+    data = static_cast<char*>(mapped);
+  }
+
+  // the mapping stays valid after the file is closed
+  close(fd);
+}
+
+LSDMappedFile::~LSDMappedFile()
+{
+  if (data != NULL)
+  {
+    munmap(data, size);
+  }
+}
+
+bool LSDMappedFile::is_same_file(string other_filename) const
+{
+  struct stat file_info;
+  if (stat(other_filename.c_str(), &file_info) != 0)
+  {
+    return false;
+  }
+  return ((unsigned long)file_info.st_dev == device
+          && (unsigned long)file_info.st_ino == inode);
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Returns the text between the curly brackets of an ENVI header line
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+static string ENVI_bracketed_value(string line)
+{
+  size_t start_pos = line.find("{");
+  size_t end_pos = line.find("}");
+  if (start_pos == string::npos || end_pos == string::npos || end_pos < start_pos)
+  {
+    return "";
+  }
+  return line.substr(start_pos+1, end_pos-start_pos-1);
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Returns the text after the = of an ENVI header line
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+static string ENVI_value(string line)
+{
+  size_t eq_pos = line.find("=");
+  if (eq_pos == string::npos)
+  {
+    return "";
+  }
+  return line.substr(eq_pos+1);
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Returns the keyword before the = of an ENVI header line, in lower case
+// and without surrounding white space
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+static string ENVI_key(string line)
+{
+  size_t eq_pos = line.find("=");
+  if (eq_pos == string::npos)
+  {
+    return "";
+  }
+  string key = line.substr(0, eq_pos);
+  size_t first = key.find_first_not_of(" \t");
+  size_t last = key.find_last_not_of(" \t");
+  if (first == string::npos)
+  {
+    return "";
+  }
+  key = key.substr(first, last-first+1);
+  for (size_t i = 0; i<key.size(); i++)
+  {
+    key[i] = tolower(key[i]);
+  }
+  return key;
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Reads the header of a .flt (ESRI) or .bil (ENVI) raster. Unlike the
+// readers in LSDRaster this also records the byte order and the header
+// offset, both of which decide whether the data can be used in place.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+LSDBinaryRasterHeader read_binary_raster_header(string filename, string extension)
+{
+  LSDBinaryRasterHeader header;
+  string header_filename = filename+".hdr";
+
+  ifstream ifs(header_filename.c_str());
+  if( ifs.fail() )
+  {
+    cout << "\nFATAL ERROR: the header file \"" << header_filename
+         << "\" doesn't exist" << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  const unsigned short endian_test = 1;
+  bool little_endian = (*reinterpret_cast<const unsigned char*>(&endian_test) == 1);
+
+  if (extension == "flt")
+  {
+    // ESRI header: one keyword and one value per line
+    header.DataType = 4;
+    bool lsb_first = true;
+    string key;
+    string value;
+    while (ifs >> key >> value)
+    {
+      for (size_t i = 0; i<key.size(); i++)
+      {
+        key[i] = tolower(key[i]);
+      }
+      if (key == "ncols")
+      {
+        header.NCols = atoi(value.c_str());
+      }
+      else if (key == "nrows")
+      {
+        header.NRows = atoi(value.c_str());
+      }
+      else if (key == "xllcorner" || key == "xllcenter")
+      {
+        header.XMinimum = atof(value.c_str());
+      }
+      else if (key == "yllcorner" || key == "yllcenter")
+      {
+        header.YMinimum = atof(value.c_str());
+      }
+      else if (key == "cellsize")
+      {
+        header.DataResolution = atof(value.c_str());
+      }
+      else if (key == "nodata_value")
+      {
+        header.NoDataValue = atof(value.c_str());
+      }
+      else if (key == "byteorder")
+      {
+        lsb_first = (value == "LSBFIRST" || value == "I");
+      }
+    }
+    header.NativeByteOrder = (lsb_first == little_endian);
+  }
+  else if (extension == "bil")
+  {
+    string first;
+    ifs >> first;
+    if (first != "ENVI")
+    {
+      cout << "\nFATAL ERROR: this is not an ENVI header file!, first line is: "
+           << first << endl;
+      exit(EXIT_FAILURE);
+    }
+
+    bool msb_first = false;
+    string line;
+    while (getline(ifs, line))
+    {
+      string key = ENVI_key(line);
+      if (key == "samples")
+      {
+        header.NCols = atoi(ENVI_value(line).c_str());
+      }
+      else if (key == "lines")
+      {
+        header.NRows = atoi(ENVI_value(line).c_str());
+      }
+      else if (key == "header offset")
+      {
+        header.HeaderOffset = size_t(atol(ENVI_value(line).c_str()));
+      }
+      else if (key == "data type")
+      {
+        header.DataType = atoi(ENVI_value(line).c_str());
+      }
+      else if (key == "byte order")
+      {
+        msb_first = (atoi(ENVI_value(line).c_str()) == 1);
+      }
+      else if (key == "data ignore value")
+      {
+        header.NoDataValue = atof(ENVI_value(line).c_str());
+      }
+      else if (key == "map info")
+      {
+        string info_str = ENVI_bracketed_value(line);
+        header.GeoReferencingStrings["ENVI_map_info"] = info_str;
+
+        vector<string> mapinfo_strings;
+        istringstream iss(info_str);
+        string substr;
+        while (getline(iss, substr, ','))
+        {
+          mapinfo_strings.push_back(substr);
+        }
+        if (mapinfo_strings.size() < 7)
+        {
+          cout << "\nFATAL ERROR: cannot parse the map info in " << header_filename << endl;
+          exit(EXIT_FAILURE);
+        }
+        header.XMinimum = atof(mapinfo_strings[3].c_str());
+        header.YMinimum = atof(mapinfo_strings[4].c_str());   // YMax until NRows is known
+        header.DataResolution = atof(mapinfo_strings[5].c_str());
+        if (mapinfo_strings[5] != mapinfo_strings[6])
+        {
+          cout << "Warning! Loading ENVI DEM, but X and Y data spacing are different!" << endl;
+        }
+      }
+      else if (key == "coordinate system string")
+      {
+        header.GeoReferencingStrings["ENVI_coordinate_system"] = ENVI_bracketed_value(line);
+      }
+    }
+
+    // the map info gives the top edge: same convention as LSDRaster::read_raster
+    if (header.GeoReferencingStrings.find("ENVI_map_info") != header.GeoReferencingStrings.end())
+    {
+      header.YMinimum = header.YMinimum - header.NRows*header.DataResolution;
+    }
+    header.NativeByteOrder = (msb_first != little_endian);
+  }
+  else
+  {
+    cout << "\nFATAL ERROR: only flt and bil rasters can be memory mapped, you entered: "
+         << extension << endl;
+    exit(EXIT_FAILURE);
+  }
+  ifs.close();
+
+  return header;
+}
+
+#endif
@@ -0,0 +1,95 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDMappedFile
+// Land Surface Dynamics memory mapped files
+//
+// Maps the binary raster formats (.flt and .bil) into memory so that
+// LSDRaster and LSDIndexRaster can use their data in place, through the
+// page cache, instead of copying them onto the heap.
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDMappedFile_H
+#define LSDMappedFile_H
+
+#include <map>
+#include <string>
+using namespace std;
+
+
+/// @brief How a raster file is mapped into memory
+/// @details map_read_only shares the page cache with all other readers
+/// of the file; writing to the raster data is then an error (SIGSEGV).
+/// map_copy_on_write also shares the page cache, but pages that are
+/// written to get a private copy. Neither ever modifies the file.
+enum LSDMapMode { map_read_only, map_copy_on_write };
+
+
+///@brief A file mapped into memory, unmapped when the object is destroyed.
+class LSDMappedFile
+{
+  public:
+  /// @brief Maps the whole of a file
+  /// @param filename the full name of the file, including extension
+  /// @param mode read only or copy on write
+  LSDMappedFile(string filename, LSDMapMode mode);
+
+  ~LSDMappedFile();
+
+  /// @return the start of the mapped file
+  char* get_data() const { return data; }
+
+  /// @return the size of the mapped file in bytes
+  size_t get_size() const { return size; }
+
+  /// @return the name of the mapped file
+  string get_filename() const { return filename; }
+
+  /// @return true if other_filename names the mapped file (by device and
+  /// inode, so different paths to the same file are recognised)
+  bool is_same_file(string other_filename) const;
+
+  private:
+  // not copyable: the mapping is owned by one object
+  LSDMappedFile(const LSDMappedFile&);
+  LSDMappedFile& operator=(const LSDMappedFile&);
+
+  string filename;
+  char* data;
+  size_t size;
+  unsigned long device;
+  unsigned long inode;
+};
+
+
+///@brief The header of a binary raster (.flt with an ESRI header, .bil
+/// with an ENVI header), as needed to use its data in place.
+struct LSDBinaryRasterHeader
+{
+  int NRows = 0;
+  int NCols = 0;
+  float XMinimum = 0;
+  float YMinimum = 0;
+  float DataResolution = 0;
+  float NoDataValue = -9999;
+
+  /// ENVI data type: 2 = 16 bit integer, 3 = 32 bit integer, 4 = 32 bit float
+  int DataType = 4;
+
+  /// Bytes preceding the data in the data file
+  size_t HeaderOffset = 0;
+
+  /// True if the data are stored in the native byte order of this machine
+  bool NativeByteOrder = true;
+
+  /// ENVI_map_info and ENVI_coordinate_system strings, if any
+  map<string,string> GeoReferencingStrings;
+};
+
+/// @brief Reads the .hdr file belonging to a .flt or .bil raster
+/// @param filename the raster filename without extension
+/// @param extension flt or bil
+/// @return the header
+LSDBinaryRasterHeader read_binary_raster_header(string filename, string extension);
+
+#endif
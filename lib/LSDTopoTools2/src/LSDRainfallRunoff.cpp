@@ -139,7 +139,7 @@ void runoffGrid::create(int imax, int jmax)
 void runoffGrid::create(int current_rainfall_timestep, int imax, int jmax,
                                 int rain_factor, double M,
                                 const rainGrid& current_rainGrid,
-                                const TNT::Array2D<double>& elevations)
+                                const LSDGrid<double>& elevations)
 {
   std::cout << "Creating a RUNOFF GRID OBJECT FROM RAINGRID..." << std::endl;
   // set arrays to relevant size for model domain
@@ -174,7 +174,7 @@ void runoffGrid::write_runoffGrid_to_raster_file(double xmin,
 
 void runoffGrid::calculate_runoff(int rain_factor, double M, int jmax, int imax, 
                                   const rainGrid& current_rainGrid, 
-                                  const TNT::Array2D<double>& elevations)
+                                  const LSDGrid<double>& elevations)
 {
   //std::cout << "calculate_runoff" << std::endl;
   // DAV addeded pragma for testing 08/2016
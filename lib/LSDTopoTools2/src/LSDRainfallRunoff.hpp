@@ -21,6 +21,7 @@
 #define LSDRAINFALLRUNOFF_H
 
 #include "TNT/tnt.h"
+#include "LSDGrid.hpp"
 #include "LSDStatsTools.hpp" // This contains some spline interpolation functions already
 
 /// @brief rainGrid is a class used to store and manipulate rainfall data.
@@ -62,7 +63,7 @@ public:
   /// extra third variable which would be terrain in most cases (see
   /// Tait et al 2006, for example)
   void interpolateRainfall_RectTrivariateSpline(rainGrid& raingrid,
-                                                const TNT::Array2D<double>& elevation);
+                                                const LSDGrid<double>& elevation);
   
   /// Takes the rainfall data for a current timestep and
   /// reshapes it into a 2D array. 
@@ -135,7 +136,7 @@ public:
   runoffGrid(int current_rainfall_timestep, int imax, int jmax,
                      int rain_factor, double M,
                      const rainGrid& current_rainGrid,
-                     const TNT::Array2D<double>& elevations)
+                     const LSDGrid<double>& elevations)
   {
     create(current_rainfall_timestep, imax, jmax,
            rain_factor, M,
@@ -152,7 +153,7 @@ public:
   /// @params Takes a ref to a rainGrid object and the elevations array from LSDCatchmentModel
   void calculate_runoff(int rain_factor, double M, int jmax, int imax, 
                         const rainGrid &current_rainGrid, 
-                        const TNT::Array2D<double>& elevations);
+                        const LSDGrid<double>& elevations);
   
   void write_runoffGrid_to_raster_file(double xmin,
                                        double ymin,
@@ -178,7 +179,7 @@ private:
   void create(int imax, int jmax);
   void create(int current_rainfall_timestep, int imax, int jmax,
          int rain_factor, double M,
-         const rainGrid& current_rainGrid, const TNT::Array2D<double>& elevations);
+         const rainGrid& current_rainGrid, const LSDGrid<double>& elevations);
 };
 
 
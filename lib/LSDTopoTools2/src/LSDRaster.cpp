@@ -108,6 +108,7 @@
 #include "LSDStatsTools.hpp"
 #include "LSDIndexRaster.hpp"
 #include "LSDShapeTools.hpp"
+#include "LSDMappedFile.hpp"
 using namespace std;
 using namespace TNT;
 using namespace JAMA;
@@ -136,6 +137,7 @@ LSDRaster& LSDRaster::operator=(const LSDRaster& rhs)
     create(rhs.get_NRows(),rhs.get_NCols(),rhs.get_XMinimum(),rhs.get_YMinimum(),
            rhs.get_DataResolution(),rhs.get_NoDataValue(),rhs.get_RasterData(),
            rhs.get_GeoReferencingStrings());
+    MappedData.reset();
    }
   return *this;
  }
@@ -159,6 +161,14 @@ void LSDRaster::create(string filename, string extension)
   read_raster(filename,extension);
 }
 
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// this creates a raster from a file mapped into memory
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+void LSDRaster::create(string filename, string extension, LSDMapMode map_mode)
+{
+  read_raster_mapped(filename,extension,map_mode);
+}
+
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 // this creates a raster filled with no data values
 // SMM 2012
@@ -290,6 +300,405 @@ void LSDRaster::create(LSDIndexRaster& IntLSDRaster)
 
 
 
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Fast ascii raster input and output
+//
+// The ascii readers below map the file into memory, split the data into
+// chunks on line boundaries and parse the chunks in parallel, straight
+// into the destination array. Numbers are converted without the stream
+// machinery: plain decimals take an exact fast path (the digits fit in a
+// double and are scaled by an exact power of ten, so the result is
+// correctly rounded) and anything else goes through strtod.
+//
+// The ascii writers format blocks of rows in parallel with the same
+// %.6g format as setprecision(6) on a stream, and write each block in
+// one go.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+// bytes of ascii data handed to each parallel task
+static const size_t ASCII_CHUNK_BYTES = size_t(1) << 22;
+
+// values formatted per block when writing ascii rasters
+static const size_t ASCII_WRITE_BLOCK_VALUES = size_t(1) << 22;
+
+static inline bool is_ascii_space(char c)
+{
+  // c <= ' ' covers space, \t, \n, \v, \f and \r (and other control
+  // characters, which have no business in an ascii raster either)
+  return ((unsigned char)c <= ' ');
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Converts the number starting at p, which must not be white space, and
+// moves p past it. Returns false if it is not a number.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+static bool parse_ascii_number(const char*& p, const char* end, double& value)
+{
+  static const double powers_of_ten[] =
+    { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+  const char* start = p;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+'))
+  {
+    negative = (*p == '-');
+    ++p;
+  }
+
+  uint64_t mantissa = 0;
+  int significant_digits = 0;
+  int exponent = 0;
+  bool any_digits = false;
+  bool exact = true;
+  while (p < end && *p >= '0' && *p <= '9')
+  {
+    any_digits = true;
+    if (significant_digits < 19)
+    {
+      mantissa = mantissa*10 + uint64_t(*p - '0');
+      if (mantissa != 0) significant_digits++;
+    }
+    else
+    {
+      exponent++;
+      exact = false;
+    }
+    ++p;
+  }
+  if (p < end && *p == '.')
+  {
+    ++p;
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+      any_digits = true;
+      if (significant_digits < 19)
+      {
+        mantissa = mantissa*10 + uint64_t(*p - '0');
+        if (mantissa != 0) significant_digits++;
+        exponent--;
+      }
+      else
+      {
+        exact = false;
+      }
+      ++p;
+    }
+  }
+  if (any_digits && p < end && (*p == 'e' || *p == 'E'))
+  {
+    ++p;
+    bool negative_exponent = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+      negative_exponent = (*p == '-');
+      ++p;
+    }
+    int explicit_exponent = 0;
+    bool any_exponent_digits = false;
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+      any_exponent_digits = true;
+      if (explicit_exponent < 100000) explicit_exponent = explicit_exponent*10 + (*p - '0');
+      ++p;
+    }
+    if (!any_exponent_digits) exact = false;
+    exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+  }
+
+  if (any_digits && (p == end || is_ascii_space(*p)) && exact
+      && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+  {
+    double result = double(mantissa);
+    result = (exponent < 0) ? result/powers_of_ten[-exponent] : result*powers_of_ten[exponent];
+    value = negative ? -result : result;
+    return true;
+  }
+
+  // everything else (long mantissas, large exponents, nan, inf): strtod
+  while (p < end && !is_ascii_space(*p)) ++p;
+  char buffer[128];
+  size_t length = size_t(p - start);
+  if (length >= sizeof(buffer)) return false;
+  memcpy(buffer, start, length);
+  buffer[length] = '\0';
+  char* parsed_end;
+  value = strtod(buffer, &parsed_end);
+  return (parsed_end == buffer + length);
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Formats value as printf's %.6g followed by a space, and returns the
+// number of characters written to buffer (at least 32 long). Values that
+// %.6g prints without an exponent are converted here: the value is scaled
+// to six digits by an exact power of ten, and only if that product is
+// too close to a rounding boundary to be sure of the digits does this
+// defer to snprintf, as it does for everything else.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+static int format_ascii_number(double value, char* buffer)
+{
+  static const double powers_of_ten[] =
+    { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+
+  double magnitude = fabs(value);
+  if (magnitude >= 1e-4 && magnitude < 999999.5)
+  {
+    // decimal exponent of the value, 10^exponent <= magnitude
+    int exponent = int(floor(log10(magnitude)));
+    if (exponent >= -4 && exponent <= 5)
+    {
+      double scaled = magnitude*powers_of_ten[5-exponent];
+      if (scaled >= 100000.0 && scaled < 1000000.0)
+      {
+        double rounded = floor(scaled + 0.5);
+        double distance_to_tie = fabs(scaled - floor(scaled) - 0.5);
+        if (distance_to_tie > 1e-6 && rounded < 1000000.0)
+        {
+          // six significant digits, then the position of the decimal point
+          long digits = long(rounded);
+          char digit_chars[6];
+          for (int k = 5; k >= 0; --k)
+          {
+            digit_chars[k] = char('0' + digits % 10);
+            digits /= 10;
+          }
+          int NDigits = 6;
+          while (NDigits > 1 && NDigits > exponent+1 && digit_chars[NDigits-1] == '0') NDigits--;
+
+          char* out = buffer;
+          if (value < 0) *out++ = '-';
+          if (exponent < 0)
+          {
+            *out++ = '0';
+            *out++ = '.';
+            for (int k = 0; k < -exponent-1; ++k) *out++ = '0';
+            for (int k = 0; k < NDigits; ++k) *out++ = digit_chars[k];
+          }
+          else
+          {
+            for (int k = 0; k <= exponent; ++k) *out++ = digit_chars[k];
+            if (NDigits > exponent+1)
+            {
+              *out++ = '.';
+              for (int k = exponent+1; k < NDigits; ++k) *out++ = digit_chars[k];
+            }
+          }
+          *out++ = ' ';
+          return int(out - buffer);
+        }
+      }
+    }
+  }
+  else if (value == 0 && !signbit(value))
+  {
+    buffer[0] = '0';
+    buffer[1] = ' ';
+    return 2;
+  }
+
+  return snprintf(buffer, 32, "%.6g ", value);
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Reads the header of an ascii raster (pairs of an ESRI header keyword
+// and its value, up to the first token that is not a keyword) and
+// returns the offset of the data. The header must at least give ncols
+// and nrows.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+static size_t read_ascii_raster_header(const char* data, size_t size, string FILENAME,
+                                       int& NCols, int& NRows, float& XMinimum,
+                                       float& YMinimum, float& DataResolution,
+                                       int& NoDataValue)
+{
+  NCols = -1;
+  NRows = -1;
+  const char* end = data + size;
+  const char* p = data;
+  while (true)
+  {
+    while (p < end && is_ascii_space(*p)) ++p;
+    if (p == end || !isalpha(*p)) break;
+
+    const char* key_end = p;
+    while (key_end < end && !is_ascii_space(*key_end)) ++key_end;
+    string key(p, key_end);
+    for (size_t i = 0; i<key.size(); i++) key[i] = tolower(key[i]);
+
+    // the data start at the first token that is not a header keyword,
+    // which may also begin with a letter (nan, inf)
+    if (key != "ncols" && key != "nrows" && key != "xllcorner" && key != "xllcenter"
+        && key != "yllcorner" && key != "yllcenter" && key != "cellsize" && key != "nodata_value")
+    {
+      break;
+    }
+
+    const char* value_start = key_end;
+    while (value_start < end && is_ascii_space(*value_start)) ++value_start;
+    const char* value_end = value_start;
+    double value;
+    if (value_start == end || !parse_ascii_number(value_end, end, value))
+    {
+      cout << "\nFATAL ERROR: cannot read the value of " << key << " in the header of "
+           << FILENAME << endl;
+      exit(EXIT_FAILURE);
+    }
+    if (key == "ncols") NCols = int(value);
+    else if (key == "nrows") NRows = int(value);
+    else if (key == "xllcorner" || key == "xllcenter") XMinimum = float(value);
+    else if (key == "yllcorner" || key == "yllcenter") YMinimum = float(value);
+    else if (key == "cellsize") DataResolution = float(value);
+    else if (key == "nodata_value") NoDataValue = int(value);
+
+    p = value_end;
+  }
+
+  if (NCols < 0 || NRows < 0)
+  {
+    cout << "\nFATAL ERROR: " << FILENAME << " has no ncols and nrows, is it an ascii raster?" << endl;
+    exit(EXIT_FAILURE);
+  }
+  return size_t(p - data);
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Parses the NRows*NCols values in data[offset, size) into the contiguous
+// array values, in parallel. A first pass counts the values in every
+// chunk, so that each chunk then knows where its values go.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+template<typename T>
+static void read_ascii_raster_data(const char* data, size_t offset, size_t size,
+                                   string FILENAME, T* values, size_t NValues)
+{
+  // chunk boundaries, each at the start of a line
+  vector<size_t> chunk_starts(1, offset);
+  size_t position = offset + ASCII_CHUNK_BYTES;
+  while (position < size)
+  {
+    const char* newline = static_cast<const char*>(memchr(data + position, '\n', size - position));
+    if (newline == NULL) break;
+    position = size_t(newline - data) + 1;
+    if (position < size) chunk_starts.push_back(position);
+    position += ASCII_CHUNK_BYTES;
+  }
+  chunk_starts.push_back(size);
+  int NChunks = int(chunk_starts.size()) - 1;
+
+  // count the values in each chunk
+  vector<size_t> chunk_first_value(NChunks+1, 0);
+  #pragma omp parallel for schedule(dynamic)
+  for (int chunk = 0; chunk < NChunks; ++chunk)
+  {
+    size_t count = 0;
+    bool in_value = false;
+    for (size_t i = chunk_starts[chunk]; i < chunk_starts[chunk+1]; ++i)
+    {
+      bool space = is_ascii_space(data[i]);
+      if (!space && !in_value) count++;
+      in_value = !space;
+    }
+    chunk_first_value[chunk+1] = count;
+  }
+  for (int chunk = 0; chunk < NChunks; ++chunk)
+  {
+    chunk_first_value[chunk+1] += chunk_first_value[chunk];
+  }
+  if (chunk_first_value[NChunks] != NValues)
+  {
+    cout << "\nFATAL ERROR: " << FILENAME << " holds " << chunk_first_value[NChunks]
+         << " values, its header says " << NValues << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // and parse them
+  bool all_numbers = true;
+  #pragma omp parallel for schedule(dynamic) reduction(&&:all_numbers)
+  for (int chunk = 0; chunk < NChunks; ++chunk)
+  {
+    T* value = values + chunk_first_value[chunk];
+    const char* p = data + chunk_starts[chunk];
+    const char* end = data + chunk_starts[chunk+1];
+    while (true)
+    {
+      while (p < end && is_ascii_space(*p)) ++p;
+      if (p == end) break;
+      double number;
+      if (!parse_ascii_number(p, end, number))
+      {
+        all_numbers = false;
+        number = 0;
+      }
+      *value++ = T(number);
+    }
+  }
+  if (!all_numbers)
+  {
+    cout << "\nFATAL ERROR: " << FILENAME << " contains values that are not numbers" << endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Reads an ascii raster: the header into the given variables, and the
+// data into a new array
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+template<typename T>
+static Array2D<T> read_ascii_raster_file(string FILENAME, int& NCols, int& NRows,
+                                         float& XMinimum, float& YMinimum,
+                                         float& DataResolution, int& NoDataValue)
+{
+  LSDMappedFile file(FILENAME, map_read_only);
+  const char* data = file.get_data();
+  size_t offset = read_ascii_raster_header(data, file.get_size(), FILENAME, NCols, NRows,
+                                           XMinimum, YMinimum, DataResolution, NoDataValue);
+
+  Array2D<T> values(NRows, NCols);
+  if (NRows > 0 && NCols > 0)
+  {
+    read_ascii_raster_data(data, offset, file.get_size(), FILENAME, values[0],
+                           size_t(NRows)*size_t(NCols));
+  }
+  return values;
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Writes the data of an ascii raster, in the same layout as the stream
+// based writers used to: every value followed by a space, and a newline
+// between rows
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+template<typename T>
+static void write_ascii_raster_data(ofstream& data_out, const Array2D<T>& values,
+                                    int NRows, int NCols)
+{
+  if (NRows <= 0 || NCols <= 0) return;
+
+  int rows_per_block = int(std::max(size_t(1), ASCII_WRITE_BLOCK_VALUES/size_t(NCols)));
+  vector<string> lines(std::min(rows_per_block, NRows));
+  for (int first_row = 0; first_row < NRows; first_row += rows_per_block)
+  {
+    int NBlockRows = std::min(rows_per_block, NRows - first_row);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int k = 0; k < NBlockRows; ++k)
+    {
+      int i = first_row + k;
+      string& line = lines[k];
+      line.clear();
+      char buffer[64];
+      for (int j = 0; j < NCols; ++j)
+      {
+        int length = format_ascii_number(double(values[i][j]), buffer);
+        line.append(buffer, length);
+      }
+      if (i != NRows-1) line += '\n';
+    }
+
+    for (int k = 0; k < NBlockRows; ++k)
+    {
+      data_out.write(lines[k].data(), streamsize(lines[k].size()));
+    }
+  }
+}
+
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 // This function reads a DEM
 // One has to provide both the filename and the extension
@@ -320,48 +729,9 @@ void LSDRaster::read_raster(string filename, string extension)
 
   if (extension == "asc")
   {
-    // open the data file
-    ifstream data_in(string_filename.c_str());
-
-    if( data_in.fail() )
-    {
-      cout << "\nFATAL ERROR: the data file \"" << string_filename
-          << "\" doesn't exist" << std::endl;
-      exit(EXIT_FAILURE);
-    }
-
-    //Read in raster data
-    string str;      // a temporary string for discarding text
-
-    // read the georeferencing data and metadata
-    data_in >> str >> NCols;
-    //cout << "NCols: " << NCols << " str: " << endl;
-    data_in >> str >> NRows;
-    //cout << "NRows: " << NRows << " str: " << endl;
-    data_in >> str >> XMinimum >> str >> YMinimum
-          >> str >> DataResolution
-          >> str >> NoDataValue;
-
-    //cout << "Loading asc file; NCols: " << NCols << " NRows: " << NRows << endl
-    //     << "X minimum: " << XMinimum << " YMinimum: " << YMinimum << endl
-    //     << "Data Resolution: " << DataResolution << " and No Data Value: "
-    //     << NoDataValue << endl;
-
-    // this is the array into which data is fed
-    Array2D<float> data(NRows,NCols,NoDataValue);
-
-    // read the data
-    for (int i=0; i<NRows; ++i)
-    {
-      for (int j=0; j<NCols; ++j)
-      {
-        data_in >> data[i][j];
-      }
-    }
-    data_in.close();
-
-    // now update the objects raster data
-    RasterData = data.copy();
+    // the data are parsed in parallel, straight into the array
+    RasterData = read_ascii_raster_file<float>(string_filename, NCols, NRows, XMinimum,
+                                               YMinimum, DataResolution, NoDataValue);
   }
   else if (extension == "flt")
   {
@@ -830,7 +1200,70 @@ void LSDRaster::read_raster(string filename, string extension)
     exit(EXIT_FAILURE);
   }
 
+  // the data are now on the heap
+  MappedData.reset();
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// read_raster_mapped
+// Reads a flt or bil raster by mapping the data file into memory, and
+// points RasterData straight at the mapped data. Falls back to
+// read_raster when the data cannot be used as they are.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+void LSDRaster::read_raster_mapped(string filename, string extension, LSDMapMode mode)
+{
+  string string_filename = filename+"."+extension;
+  LSDBinaryRasterHeader header = read_binary_raster_header(filename, extension);
+
+  if (header.DataType != 4 || !header.NativeByteOrder
+      || header.HeaderOffset % sizeof(float) != 0)
+  {
+    cout << "Cannot map " << string_filename << " into memory (data type "
+         << header.DataType << ", native byte order " << header.NativeByteOrder
+         << ", header offset " << header.HeaderOffset << "), reading it instead" << endl;
+    read_raster(filename, extension);
+    return;
+  }
 
+  std::shared_ptr<LSDMappedFile> mapped(new LSDMappedFile(string_filename, mode));
+  size_t NData = size_t(header.NRows)*size_t(header.NCols);
+  if (mapped->get_size() < header.HeaderOffset + NData*sizeof(float))
+  {
+    cout << "\nFATAL ERROR: the data file \"" << string_filename << "\" is "
+         << mapped->get_size() << " bytes, expected at least "
+         << header.HeaderOffset + NData*sizeof(float) << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // the data are used as they are: pages are only read from disk when
+  // first touched, so nothing here looks at the values
+  float* data = reinterpret_cast<float*>(mapped->get_data() + header.HeaderOffset);
+
+  NRows = header.NRows;
+  NCols = header.NCols;
+  XMinimum = header.XMinimum;
+  YMinimum = header.YMinimum;
+  DataResolution = header.DataResolution;
+  NoDataValue = int(header.NoDataValue);
+  GeoReferencingStrings = header.GeoReferencingStrings;
+
+  // TNT wraps data it has not allocated without taking ownership;
+  // MappedData keeps the mapping alive for as long as this raster
+  RasterData = Array2D<float>(NRows, NCols, data);
+  MappedData = mapped;
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Moves the raster data onto the heap before the file they are mapped
+// from is overwritten: truncating a mapped file invalidates the mapping.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+void LSDRaster::detach_mapped_file(string data_filename)
+{
+  if (MappedData && MappedData->is_same_file(data_filename))
+  {
+    RasterData = RasterData.copy();
+    MappedData.reset();
+  }
 }
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
@@ -838,109 +1271,32 @@ void LSDRaster::read_raster(string filename, string extension)
 // Generic function for reading rasters in ascii format
 // This is used by the LSDCatchmentModel.
 void LSDRaster::read_ascii_raster(string FILENAME)
-//TNT::Array2D<double> LSDRaster::read_ascii_raster(string FILENAME)
 {
-  //string string_filename;
-  //string dot = ".";
-  //string_filename = filename+dot+extension;
   std::cout << "\n\nLoading DEM, the filename is " << FILENAME << std::endl;
 
-  // open the data file
-  std::ifstream data_in(FILENAME.c_str());
-
-  if( data_in.fail() )
-  {
-    cout << "\nFATAL ERROR: the data file \"" << FILENAME
-        << "\" doesn't exist" << std::endl;
-    exit(EXIT_FAILURE);
-  }
-
-  //Read in raster data
-  std::string str;      // a temporary string for discarding text
-
-  // read the georeferencing data and metadata
-  data_in >> str >> NCols;
-  std::cout << "NCols: " << NCols << " str: " << std::endl;
-  data_in >> str >> NRows;
-  std::cout << "NRows: " << NRows << " str: " << std::endl;
-  data_in >> str >> XMinimum
-          >> str >> YMinimum
-          >> str >> DataResolution
-          >> str >> NoDataValue;
+  // header and data, the data parsed in parallel straight into the array
+  RasterData_dbl = read_ascii_raster_file<double>(FILENAME, NCols, NRows, XMinimum,
+                                                  YMinimum, DataResolution, NoDataValue);
 
   std::cout << "Loading asc file; NCols: " << NCols
             << " NRows: " << NRows << std::endl
             << "X minimum: " << XMinimum << " YMinimum: " << YMinimum << std::endl
             << "Data Resolution: " << DataResolution << " and No Data Value: "
             << NoDataValue << std::endl;
-
-  // this is the array into which data is fed
-  TNT::Array2D<double> asciidata(NRows,NCols,NoDataValue);
-
-  // read the data
-  for (int i=0; i<NRows; ++i)
-  {
-    for (int j=0; j<NCols; ++j)
-    {
-      data_in >> asciidata[i][j];
-    }
-  }
-  data_in.close();
-  RasterData_dbl = asciidata.copy();
-  //RasterData_dbl = asciidata.copy();
-
-  // now update the objects raster data
-  //RasterData = data.copy();
-  //return RasterData_dbl;
 }
 
 void LSDRaster::read_ascii_raster_integers(string FILENAME)
 {
-  // eugh...duplicated code...quick fix
   std::cout << "\n\nLoading DEM, the filename is " << FILENAME << std::endl;
 
-  // open the data file
-  std::ifstream data_in(FILENAME.c_str());
-
-  if( data_in.fail() )
-  {
-    cout << "\nFATAL ERROR: the data file \"" << FILENAME
-        << "\" doesn't exist" << std::endl;
-    exit(EXIT_FAILURE);
-  }
-
-  //Read in raster data
-  std::string str;      // a temporary string for discarding text
-
-  // read the georeferencing data and metadata
-  data_in >> str >> NCols;
-  std::cout << "NCols: " << NCols << " str: " << std::endl;
-  data_in >> str >> NRows;
-  std::cout << "NRows: " << NRows << " str: " << std::endl;
-  data_in >> str >> XMinimum
-          >> str >> YMinimum
-          >> str >> DataResolution
-          >> str >> NoDataValue;
+  RasterData_int = read_ascii_raster_file<int>(FILENAME, NCols, NRows, XMinimum,
+                                               YMinimum, DataResolution, NoDataValue);
 
   std::cout << "Loading asc file; NCols: " << NCols
             << " NRows: " << NRows << std::endl
             << "X minimum: " << XMinimum << " YMinimum: " << YMinimum << std::endl
             << "Data Resolution: " << DataResolution << " and No Data Value: "
             << NoDataValue << std::endl;
-
-  // this is the array into which data is fed
-  TNT::Array2D<int> asciidata(NRows,NCols,NoDataValue);
-
-  // read the data
-  for (int i=0; i<NRows; ++i)
-  {
-    for (int j=0; j<NCols; ++j)
-    {
-      data_in >> asciidata[i][j];
-    }
-  }
-  data_in.close();
-  RasterData_int = asciidata.copy();
 }
 
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
@@ -978,14 +1334,7 @@ void LSDRaster::write_raster(string filename, string extension)
        << "\nNODATA_value\t" << NoDataValue << endl;
 
 
-    for (int i=0; i<NRows; ++i)
-    {
-      for (int j=0; j<NCols; ++j)
-      {
-        data_out << setprecision(6) << RasterData[i][j] << " ";
-      }
-      if (i != NRows-1) data_out << endl;
-    }
+    write_ascii_raster_data(data_out, RasterData, NRows, NCols);
     data_out.close();
 
   }
@@ -1008,16 +1357,14 @@ void LSDRaster::write_raster(string filename, string extension)
       << "\nbyteorder     LSBFIRST" << endl;
     header_ofs.close();
 
-    // now do the main data
+    // now do the main data. The rows of RasterData are contiguous, so
+    // this is a single write
+    detach_mapped_file(string_filename);
     ofstream data_ofs(string_filename.c_str(), ios::out | ios::binary);
-    float temp;
-    for (int i=0; i<NRows; ++i)
+    if (NRows > 0 && NCols > 0)
     {
-      for (int j=0; j<NCols; ++j)
-      {
-        temp = float(RasterData[i][j]);
-        data_ofs.write(reinterpret_cast<char *>(&temp),sizeof(temp));
-      }
+      data_ofs.write(reinterpret_cast<const char *>(RasterData[0]),
+                     streamsize(NRows)*streamsize(NCols)*streamsize(sizeof(float)));
     }
     data_ofs.close();
   }
@@ -1084,23 +1431,14 @@ void LSDRaster::write_raster(string filename, string extension)
 
     header_ofs.close();
 
-    // now do the main data
+    // now do the main data. The rows of RasterData are contiguous, so
+    // this is a single write
+    detach_mapped_file(string_filename);
     ofstream data_ofs(string_filename.c_str(), ios::out | ios::binary);
-    float temp;
-    for (int i=0; i<NRows; ++i)
+    if (NRows > 0 && NCols > 0)
     {
-      for (int j=0; j<NCols; ++j)
-      {
-
-        temp = float(RasterData[i][j]);
-        //if (i%250 == 0 && j%250 == 0)
-        //{
-        //  cout << "data["<<i<<"]["<<j<<"]: " << temp << endl;
-        //}
-
-
-        data_ofs.write(reinterpret_cast<char *>(&temp),sizeof(temp));
-      }
+      data_ofs.write(reinterpret_cast<const char *>(RasterData[0]),
+                     streamsize(NRows)*streamsize(NCols)*streamsize(sizeof(float)));
     }
     data_ofs.close();
   }
@@ -1252,14 +1590,7 @@ void LSDRaster::write_double_asc_raster(string string_filename)
      << "\nNODATA_value\t" << NoDataValue << endl;
 
 
-  for (int i=0; i<NRows; ++i)
-  {
-    for (int j=0; j<NCols; ++j)
-    {
-      data_out << setprecision(6) << RasterData_dbl[i][j] << " ";
-    }
-    if (i != NRows-1) data_out << endl;
-  }
+  write_ascii_raster_data(data_out, RasterData_dbl, NRows, NCols);
   data_out.close();
 }
 
@@ -2548,7 +2879,7 @@ float LSDRaster::WrapSample(int row, int col)
   }
   else
   {
-    wraprow = NRows - (-row % NRows);
+    wraprow = (NRows - (-row % NRows)) % NRows;
   }
   if(col >= 0)
   {
@@ -2556,7 +2887,7 @@ float LSDRaster::WrapSample(int row, int col)
   }
   else
   {
-    wrapcol = NCols - (-col % NCols);
+    wrapcol = (NCols - (-col % NCols)) % NCols;
   }
 
   //cout << "Nrows: " << NRows << " row: " << row << " wraprow: " << wraprow << endl;
@@ -2581,7 +2912,7 @@ void LSDRaster::SetWrapSample(int row, int col, float value)
   }
   else
   {
-    wraprow = NRows - (-row % NRows);
+    wraprow = (NRows - (-row % NRows)) % NRows;
   }
   if(col >= 0)
   {
@@ -2589,7 +2920,7 @@ void LSDRaster::SetWrapSample(int row, int col, float value)
   }
   else
   {
-    wrapcol = NCols - (-col % NCols);
+    wrapcol = (NCols - (-col % NCols)) % NCols;
   }
 
   RasterData[wraprow][wrapcol] = value;
@@ -105,9 +105,11 @@ Tools are included to:
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include "TNT/tnt.h"
 #include "LSDIndexRaster.hpp"
 #include "LSDShapeTools.hpp"
+#include "LSDMappedFile.hpp"
 using namespace std;
 using namespace TNT;
 // Sorting compiling problems with MSVC
@@ -138,6 +140,14 @@ class LSDRaster
   /// @param extension A String, the file extension to be loaded.
   LSDRaster(string filename, string extension)  { create(filename, extension); }
 
+  /// @brief Create an LSDRaster from a .flt or .bil file mapped into memory.
+  /// @details See read_raster_mapped.
+  /// @param filename A String, the file to be loaded.
+  /// @param extension A String, the file extension to be loaded (flt or bil).
+  /// @param map_mode map_read_only or map_copy_on_write
+  LSDRaster(string filename, string extension, LSDMapMode map_mode)
+      { create(filename, extension, map_mode); }
+
   /// @brief Create an LSDRaster from memory.
   /// @return LSDRaster
   /// @param nrows An integer of the number of rows.
@@ -200,6 +210,10 @@ class LSDRaster
   /// @return Raster values as a 2D Array.
   Array2D<float> get_RasterData() const { return RasterData.copy(); }
 
+  /// @return The raster values themselves. For a memory mapped raster
+  /// they point into the mapping, which is kept alive by this raster:
+  /// TNT copies of the array are shallow, and dangle once the raster is
+  /// gone. Use get_RasterData for data that outlive the raster.
   Array2D<float>* get_RasterDataPtr() { return &RasterData; }
 
 
@@ -260,6 +274,35 @@ class LSDRaster
   /// @date 01/01/12
   void read_raster(string filename, string extension);
 
+  /// @brief Read a .flt or .bil raster by mapping its data file into memory.
+  ///
+  /// The raster data then live in the page cache rather than on the heap:
+  /// loading costs no copy, pages are only read from disk when they are
+  /// first touched, and all processes mapping the same file share them.
+  /// All the usual accessors work on the mapped data.
+  ///
+  /// With map_read_only the data must not be modified. With
+  /// map_copy_on_write pages that are written to get a private copy;
+  /// the file itself is never changed in either mode.
+  ///
+  /// The data can only be used in place if they are 32 bit floats in the
+  /// byte order of this machine, at an aligned header offset. Otherwise
+  /// the raster is read onto the heap with read_raster instead.
+  ///
+  /// Unlike read_raster, values below -1e10 in .bil files are not
+  /// replaced by the no data value, as that would touch every page of
+  /// the file on loading. Callers that need it can map the file copy
+  /// on write and call mask_to_nodata_below_threshold(-1e10).
+  ///
+  /// @param filename a string of the filename _without_ the extension.
+  /// @param extension flt or bil
+  /// @param mode map_read_only or map_copy_on_write
+  void read_raster_mapped(string filename, string extension,
+                          LSDMapMode mode = map_copy_on_write);
+
+  /// @return true if the raster data are a file mapped into memory
+  bool is_memory_mapped() const { return bool(MappedData); }
+
   /// @brief Reads a raster from an ascii file for use in LSDCatchmentModel
   /// @bug You can't return a TNT::Array properly in a function. See google for details.
   /// @author DAV
@@ -274,6 +317,7 @@ class LSDRaster
   /// @example myLSDRasterobject.read_ascii_raster("elevations.asc")
   /// @result The myLSDRasterobject.RasterData_dbl data member is now populated with an array of
   /// the DEM data. The data members for NCols, NRows, etc. are also updated.
+  /// The data are parsed in parallel (OpenMP), in chunks split on line boundaries.
   void read_ascii_raster(string FILENAME);
 
   /// @brief Reads a raster of integers and populates LSDRaster integer array member data
@@ -316,6 +360,8 @@ class LSDRaster
   void write_double_raster(string filename, string extension);
 
   /// @brief Writes out a double array to an ascii
+  /// @details Rows are formatted in parallel (OpenMP), with setprecision(6)
+  /// as before, and written a block at a time.
   void write_double_asc_raster(string string_filename);
 
   /// @brief Writes out a double array to a binary flt file
@@ -2418,6 +2464,10 @@ protected:
   /// Raster data.
   Array2D<float> RasterData;
 
+  /// The mapped file RasterData points into, if read with read_raster_mapped.
+  /// Shared so that the mapping outlives shallow copies of RasterData.
+  std::shared_ptr<LSDMappedFile> MappedData;
+
   /// These are used primarily by LSDCatchmentModel
   Array2D<double> RasterData_dbl;
   Array2D<int> RasterData_int;
@@ -2427,6 +2477,7 @@ protected:
   private:
   void create();
   void create(string filename, string extension);
+  void create(string filename, string extension, LSDMapMode map_mode);
   void create(int ncols, int nrows, float xmin, float ymin,
               float cellsize, float ndv, Array2D<float> data);
   void create(int ncols, int nrows, double xmin, double ymin,
@@ -2435,6 +2486,8 @@ protected:
               float cellsize, float ndv, Array2D<float> data, map<string,string> GRS);
   void create(LSDIndexRaster& IntLSDRaster);
 
+  void detach_mapped_file(string data_filename);
+
 };
 
 #endif
@@ -6260,7 +6260,7 @@ double get_QuadraticMean(vector<double> input_values, double bin_width)
 //
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
-void parse_line(ifstream &infile, string &parameter, string &value)
+void parse_line(istream &infile, string &parameter, string &value)
 {
   char c;
   char buff[128];
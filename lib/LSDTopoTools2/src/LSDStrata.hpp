@@ -0,0 +1,112 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDStrata
+// Land Surface Dynamics subsurface strata
+//
+// The grain size fractions of the subsurface layers (strata) below the
+// active layer of each cell of LSDCatchmentModel. The layers of a cell
+// are kept in one contiguous block, as a ring buffer with a per cell
+// offset of the top layer: depositing (a new layer on top, the bottom
+// one dropped) or eroding (the top layer removed, a new one at the
+// bottom) moves the offset and writes one layer, instead of copying
+// every layer one place up or down.
+//
+// The cells are stored in blocks of BlockSize cells, each allocated
+// on its own by add_block when the cells are first needed (see
+// LSDGrainPool). The table of blocks never changes size, so one thread
+// can add a block while others work on the cells of other blocks.
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDStrata_H
+#define LSDStrata_H
+
+#include <algorithm>
+#include <vector>
+
+
+class LSDStrata
+{
+  public:
+  /// Cells in each block of storage
+  static const int BlockSize = 64;
+
+  LSDStrata() : NLayers(0), NClasses(0), Value(0.0) {}
+
+  /// @brief Room for up to max_cells cells (grain indices) of n_layers
+  /// layers of n_classes grain size classes. No cell has storage until
+  /// its block is added; the fractions of new blocks are set to value
+  LSDStrata(int max_cells, int n_layers, int n_classes, double value = 0.0)
+    : NLayers(n_layers), NClasses(n_classes), Value(value),
+      data((max_cells + BlockSize - 1) / BlockSize),
+      top((max_cells + BlockSize - 1) / BlockSize)
+  {}
+
+  /// @brief Allocates the cells block*BlockSize to (block+1)*BlockSize-1
+  void add_block(int block)
+  {
+    data[block].assign(size_t(BlockSize)*NLayers*NClasses, Value);
+    top[block].assign(BlockSize, 0);
+  }
+
+  /// @return the number of blocks there is room for
+  int get_NBlocks() const { return int(data.size()); }
+
+  /// @return the grain size fractions of layer z of a cell, z = 0 being
+  /// the top layer (just below the active layer)
+  double* layer(int cell, int z)
+  {
+    const int offset = cell % BlockSize;
+    return &data[cell / BlockSize][(size_t(offset)*NLayers
+                                    + (top[cell / BlockSize][offset] + z) % NLayers)*NClasses];
+  }
+  const double* layer(int cell, int z) const
+  {
+    const int offset = cell % BlockSize;
+    return &data[cell / BlockSize][(size_t(offset)*NLayers
+                                    + (top[cell / BlockSize][offset] + z) % NLayers)*NClasses];
+  }
+
+  /// @brief Adds a layer on top of a cell, dropping its bottom layer
+  /// @return the new top layer, which starts as a copy of the old one
+  double* push(int cell)
+  {
+    const double* old_top = layer(cell, 0);
+    unsigned char& t = top[cell / BlockSize][cell % BlockSize];
+    t = (t + NLayers - 1) % NLayers;
+    double* new_top = layer(cell, 0);
+    std::copy(old_top, old_top + NClasses, new_top);
+    return new_top;
+  }
+
+  /// @brief Removes the top layer of a cell, adding a layer at the
+  /// bottom
+  /// @return the new bottom layer, still holding the removed top layer
+  double* pop(int cell)
+  {
+    unsigned char& t = top[cell / BlockSize][cell % BlockSize];
+    t = (t + 1) % NLayers;
+    return layer(cell, NLayers - 1);
+  }
+
+  /// @brief Sets every fraction of the blocks added so far
+  void fill(double value)
+  {
+    for (size_t block = 0; block < data.size(); block++)
+    {
+      std::fill(data[block].begin(), data[block].end(), value);
+    }
+  }
+
+  /// @return the number of layers of each cell
+  int get_NLayers() const { return NLayers; }
+
+  private:
+  int NLayers;
+  int NClasses;
+  double Value;
+  std::vector< std::vector<double> > data;
+  std::vector< std::vector<unsigned char> > top;
+};
+
+#endif
@@ -1,6 +1,10 @@
 #include <catchmentparameters.hpp>
+#include <rootinput.hpp>
 #include <LSDParameterParser.hpp>
 #include <libgeodecomp/communication/mpilayer.h>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
 
 
 CatchmentParameters::CatchmentParameters(string parameter_filename)
@@ -19,8 +23,17 @@ void CatchmentParameters::readParameters(string parameter_filename)
 	std::cout << "Reading simulation parameters from " << parameter_filename << std::endl;
     }
   
-    std::ifstream infile;
-    infile.open(parameter_filename.c_str());
+    // Rank 0 reads the file, all ranks parse the same contents
+    string contents;
+    if (!readOnRootAndBroadcast(parameter_filename, contents))
+    {
+	if(LibGeoDecomp::MPILayer().rank() == 0)
+	{
+	    std::cout << "Could not open parameter file " << parameter_filename << std::endl;
+	}
+	exit(EXIT_FAILURE);
+    }
+    std::istringstream infile(contents);
     string parameter, value, lower, lower_val;
     string bc;
   
@@ -67,6 +80,17 @@ void CatchmentParameters::readParameters(string parameter_filename)
 	    inputNetCDFGridQuantities.push_back(GridQuantity::waterDepth);
 	    inputNetCDFFileName[GridQuantity::waterDepth] = value;
 	}
+	else if (lower == "input_hydroindex_netcdf_file")
+	{
+	    notifyUser("  netCDF hydrological zone (hydroindex) input file", value);
+	    inputNetCDFGridQuantities.push_back(GridQuantity::hydroIndex);
+	    inputNetCDFFileName[GridQuantity::hydroIndex] = value;
+	}
+	else if (lower == "input_dem_raster_file")
+	{
+	    notifyUser("  DEM input file (asc, flt or bil)", value);
+	    inputRasterFileName = value;
+	}
 	// NetCDF Variables
 	else if (lower == "input_dem_netcdf_variable")
 	{
@@ -78,6 +102,11 @@ void CatchmentParameters::readParameters(string parameter_filename)
 	    notifyUser("  netCDF variable corresponding to water depth", value);
 	    inputNetCDFVariableName[GridQuantity::waterDepth] = value;
 	}
+	else if (lower == "input_hydroindex_netcdf_variable")
+	{
+	    notifyUser("  netCDF variable corresponding to hydroindex", value);
+	    inputNetCDFVariableName[GridQuantity::hydroIndex] = value;
+	}
 
 	// Grid initialisation options - 
 	// Setting up different initial conditions, 
@@ -108,6 +137,56 @@ void CatchmentParameters::readParameters(string parameter_filename)
 	{
 	    setDoubleParameter(physicalRainRate, "  Rain rate (mm/hour)", value);
 	}
+	else if (lower == "rain_schedule_file")
+	{
+	    notifyUser("  Reading rain rate changes from", value);
+	    readRainSchedule(value);
+	}
+	else if (lower == "input_rain_netcdf_file")
+	{
+	    inputRainNetCDFFileName = value;
+	    notifyUser("  Reading gridded rainfall from", value);
+	}
+	else if (lower == "input_rain_netcdf_variable")
+	{
+	    inputRainNetCDFVariableName = value;
+	    notifyUser("  Gridded rainfall netCDF variable name", value);
+	}
+	else if (lower == "rain_netcdf_interval")
+	{
+	    setDoubleParameter(rain_netcdf_interval, "  Gridded rainfall interval (s)", value);
+	}
+	else if (lower == "rain_grid_cellsize")
+	{
+	    setDoubleParameter(rain_grid_cellsize, "  Gridded rainfall cell size (m)", value);
+	}
+	else if (lower == "rain_grid_x_offset")
+	{
+	    setDoubleParameter(rain_grid_x_offset, "  Gridded rainfall x offset (m)", value);
+	}
+	else if (lower == "rain_grid_y_offset")
+	{
+	    setDoubleParameter(rain_grid_y_offset, "  Gridded rainfall y offset (m)", value);
+	}
+	else if (lower == "reach_inflow_file")
+	{
+	    notifyUser("  Reading reach inflow points from", value);
+	    readReachInflows(value);
+	}
+	else if (lower == "topmodel_runoff")
+	{
+	    topmodel_runoff = (value == "yes") ? true : false;
+	    notifyUser("  TOPMODEL runoff generation", value);
+	}
+	else if (lower == "topmodel_m_value")
+	{
+	    setDoubleParameter(topmodel_m, "  TOPMODEL m value", value);
+	}
+	else if (lower == "fast_forward_dry_periods")
+	{
+	    fast_forward_dry_periods = (value == "yes") ? true : false;
+	    notifyUser("  Fast-forward through dry periods", value);
+	}
 	
 	
 	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
@@ -133,6 +212,41 @@ void CatchmentParameters::readParameters(string parameter_filename)
 	{
 	    setDoubleParameter(froudeLimit, "  Froude number limit", value);
 	}
+	else if (lower == "hydro_model_only")
+	{
+	    hydro_model_only = (value == "yes") ? true : false;
+	    notifyUser("  Hydrology only (no erosion)", value);
+	}
+	else if (lower == "transport_law")
+	{
+	    if (value != "wilcock" && value != "einstein")
+	    {
+		if(LibGeoDecomp::MPILayer().rank() == 0)
+		{
+		    std::cout << "transport_law must be wilcock or einstein" << std::endl;
+		}
+		exit(EXIT_FAILURE);
+	    }
+	    wilcock = (value == "wilcock");
+	    notifyUser("  Sediment transport law", value);
+	}
+	else if (lower == "max_tau_velocity")
+	{
+	    setDoubleParameter(max_tau_velocity, "  Maximum velocity for shear stress", value);
+	}
+	else if (lower == "active_layer_thickness")
+	{
+	    setDoubleParameter(active_layer_thickness, "  Active layer thickness", value);
+	}
+	else if (lower == "erosion_limit")
+	{
+	    setDoubleParameter(erosion_limit, "  Erosion limit per timestep", value);
+	}
+	else if (lower == "grain_size_frac_file")
+	{
+	    notifyUser("  Reading grain sizes from", value);
+	    readGrainSizes(value);
+	}
 	else if (lower == "water_depth_erosion_threshold")
 	{
 	    setDoubleParameter(waterDepthErosionThreshold, "  Water depth erosion threshold", value);
@@ -162,6 +276,22 @@ void CatchmentParameters::readParameters(string parameter_filename)
 	{
 	    setDoubleParameter(timestep, "  time step (in seconds)", value);
 	}
+	else if (lower == "convergence_check_interval")
+	{
+	    setUnsignedIntegerParameter(convergence_check_interval, "  Interval checking for steady state / dry out", value);
+	}
+	else if (lower == "steady_state_tolerance_linf")
+	{
+	    setDoubleParameter(steady_state_tolerance_linf, "  Steady state tolerance, max water depth change between checks (m/step)", value);
+	}
+	else if (lower == "steady_state_tolerance_l2")
+	{
+	    setDoubleParameter(steady_state_tolerance_l2, "  Steady state tolerance, rms water depth change between checks (m/step)", value);
+	}
+	else if (lower == "dry_volume_threshold")
+	{
+	    setDoubleParameter(dry_volume_threshold, "  Dry catchment water volume threshold (m^3)", value);
+	}
       
 	//=-=-=-=-=-=-=-=-=-=-=-=-=-=
 	// LibGeoDecomp Options
@@ -170,6 +300,11 @@ void CatchmentParameters::readParameters(string parameter_filename)
 	{
 	    simulator = value;
 	}
+	else if (lower == "event_list_file")
+	{
+	    notifyUser("  Batch mode, reading list of event parameter files from", value);
+	    readEventList(value);
+	}
       
       
       
@@ -275,6 +410,17 @@ void CatchmentParameters::readParameters(string parameter_filename)
 	{
 	    outputNetCDFInterval[GridQuantity::celltype_double] = atoi(value.c_str());
 	}
+
+	// Performance instrumentation
+	else if (lower == "performance_report_file")
+	{
+	    performance_report_file = value;
+	    notifyUser("  Performance summary file prefix", value);
+	}
+	else if (lower == "performance_snapshot_interval")
+	{
+	    setUnsignedIntegerParameter(performance_snapshot_interval, "  Interval writing performance snapshots", value);
+	}
     }
 
     
@@ -285,6 +431,280 @@ void CatchmentParameters::readParameters(string parameter_filename)
 }
 
 
+// One event parameter file per line, blank lines and lines starting
+// with # are ignored. Events are run in the order listed.
+void CatchmentParameters::readEventList(string event_list_filename)
+{
+    string contents;
+    if (!readOnRootAndBroadcast(event_list_filename, contents))
+    {
+	if(LibGeoDecomp::MPILayer().rank() == 0)
+	{
+	    std::cout << "Could not open event list file " << event_list_filename << std::endl;
+	}
+	exit(EXIT_FAILURE);
+    }
+
+    std::istringstream infile(contents);
+    string line;
+    eventParameterFiles.clear();
+    while (std::getline(infile, line))
+    {
+	line = RemoveControlCharactersFromEndOfString(line);
+	line.erase(0, line.find_first_not_of(" \t"));
+	line.erase(line.find_last_not_of(" \t") + 1);
+	if (line.empty() || line[0] == '#')
+	    continue;
+
+	eventParameterFiles.push_back(line);
+	notifyUser("    Event", line);
+    }
+}
+
+
+// Two columns per line: the step from which a rain rate applies and
+// the rain rate (mm/hour). Steps must be increasing; before the first
+// listed step rain_rate applies.
+void CatchmentParameters::readRainSchedule(string rain_schedule_filename)
+{
+    string contents;
+    if (!readOnRootAndBroadcast(rain_schedule_filename, contents))
+    {
+	if(LibGeoDecomp::MPILayer().rank() == 0)
+	{
+	    std::cout << "Could not open rain schedule file " << rain_schedule_filename << std::endl;
+	}
+	exit(EXIT_FAILURE);
+    }
+
+    std::istringstream infile(contents);
+    string line;
+    rainScheduleStep.clear();
+    rainScheduleRate.clear();
+    while (std::getline(infile, line))
+    {
+	std::istringstream columns(line);
+	unsigned step;
+	double rate;
+	if (line.empty() || line[0] == '#' || !(columns >> step >> rate))
+	    continue;
+
+	if (!rainScheduleStep.empty() && step <= rainScheduleStep.back())
+	{
+	    if(LibGeoDecomp::MPILayer().rank() == 0)
+	    {
+		std::cout << "Steps in rain schedule file " << rain_schedule_filename << " must be increasing" << std::endl;
+	    }
+	    exit(EXIT_FAILURE);
+	}
+	
+	rainScheduleStep.push_back(step);
+	rainScheduleRate.push_back(rate);
+    }
+    
+    if(LibGeoDecomp::MPILayer().rank() == 0)
+    {
+	std::cout << "    " << rainScheduleStep.size() << " rain rate changes" << std::endl;
+    }
+}
+
+
+// One reach inflow point per line: its grid cell (x and y index, as
+// in the netCDF grid) and the file of its hydrograph. A hydrograph
+// file has two columns per line, the time (s since the start of the
+// run) and the discharge (m^3/s), with increasing times.
+void CatchmentParameters::readReachInflows(string reach_inflow_filename)
+{
+    string contents;
+    if (!readOnRootAndBroadcast(reach_inflow_filename, contents))
+    {
+	if(LibGeoDecomp::MPILayer().rank() == 0)
+	{
+	    std::cout << "Could not open reach inflow file " << reach_inflow_filename << std::endl;
+	}
+	exit(EXIT_FAILURE);
+    }
+
+    std::istringstream infile(contents);
+    string line;
+    reachInflowX.clear();
+    reachInflowY.clear();
+    reachInflowTime.clear();
+    reachInflowDischarge.clear();
+    while (std::getline(infile, line))
+    {
+	std::istringstream columns(line);
+	int x, y;
+	string hydrograph_filename;
+	if (line.empty() || line[0] == '#' || !(columns >> x >> y >> hydrograph_filename))
+	    continue;
+
+	string hydrograph;
+	if (!readOnRootAndBroadcast(hydrograph_filename, hydrograph))
+	{
+	    if(LibGeoDecomp::MPILayer().rank() == 0)
+	    {
+		std::cout << "Could not open hydrograph file " << hydrograph_filename << std::endl;
+	    }
+	    exit(EXIT_FAILURE);
+	}
+
+	vector<double> times, discharges;
+	std::istringstream hydrographLines(hydrograph);
+	while (std::getline(hydrographLines, line))
+	{
+	    std::istringstream values(line);
+	    double time, discharge;
+	    if (line.empty() || line[0] == '#' || !(values >> time >> discharge))
+		continue;
+
+	    if (!times.empty() && time <= times.back())
+	    {
+		if(LibGeoDecomp::MPILayer().rank() == 0)
+		{
+		    std::cout << "Times in hydrograph file " << hydrograph_filename << " must be increasing" << std::endl;
+		}
+		exit(EXIT_FAILURE);
+	    }
+	    times.push_back(time);
+	    discharges.push_back(discharge);
+	}
+	if (times.empty())
+	{
+	    if(LibGeoDecomp::MPILayer().rank() == 0)
+	    {
+		std::cout << "No discharges in hydrograph file " << hydrograph_filename << std::endl;
+	    }
+	    exit(EXIT_FAILURE);
+	}
+
+	reachInflowX.push_back(x);
+	reachInflowY.push_back(y);
+	reachInflowTime.push_back(times);
+	reachInflowDischarge.push_back(discharges);
+    }
+    
+    if(LibGeoDecomp::MPILayer().rank() == 0)
+    {
+	std::cout << "    " << reachInflowX.size() << " reach inflow points" << std::endl;
+    }
+}
+
+
+// Two columns per line, one line for each of the grain size classes:
+// the grain size (m) and its proportion in the initial bed
+void CatchmentParameters::readGrainSizes(string grain_size_filename)
+{
+    string contents;
+    if (!readOnRootAndBroadcast(grain_size_filename, contents))
+    {
+	if(LibGeoDecomp::MPILayer().rank() == 0)
+	{
+	    std::cout << "Could not open grain size file " << grain_size_filename << std::endl;
+	}
+	exit(EXIT_FAILURE);
+    }
+
+    std::istringstream infile(contents);
+    string line;
+    vector<double> sizes, proportions;
+    while (std::getline(infile, line))
+    {
+	std::istringstream columns(line);
+	double size, proportion;
+	if (line.empty() || line[0] == '#' || !(columns >> size >> proportion))
+	    continue;
+
+	sizes.push_back(size);
+	proportions.push_back(proportion);
+    }
+
+    if (sizes.size() != grainSizes.size())
+    {
+	if(LibGeoDecomp::MPILayer().rank() == 0)
+	{
+	    std::cout << "Grain size file " << grain_size_filename << " must list "
+		      << grainSizes.size() << " grain sizes" << std::endl;
+	}
+	exit(EXIT_FAILURE);
+    }
+    grainSizes = sizes;
+    grainProportions = proportions;
+}
+
+
+// Discharge (m^3/s) of a reach inflow point, interpolated linearly
+// between the times of its hydrograph and held constant before the
+// first and after the last
+double CatchmentParameters::reachDischarge(unsigned point, double time) const
+{
+    const vector<double>& times = reachInflowTime[point];
+    const vector<double>& discharges = reachInflowDischarge[point];
+    if (time <= times.front())
+    {
+	return discharges.front();
+    }
+    if (time >= times.back())
+    {
+	return discharges.back();
+    }
+    std::size_t upper = std::upper_bound(times.begin(), times.end(), time) - times.begin();
+    double weight = (time - times[upper-1]) / (times[upper] - times[upper-1]);
+    return (1.0 - weight) * discharges[upper-1] + weight * discharges[upper];
+}
+
+
+double CatchmentParameters::rainRateAtStep(unsigned step) const
+{
+    double rate = physicalRainRate;
+    for (unsigned i=0; i<rainScheduleStep.size() && rainScheduleStep[i] <= step; i++)
+    {
+	rate = rainScheduleRate[i];
+    }
+    return rate;
+}
+
+
+// First step at or after step from which it rains, or
+// no_of_iterations if it never rains again
+unsigned CatchmentParameters::nextRainStep(unsigned step) const
+{
+    if (rainRateAtStep(step) > 0)
+    {
+	return step;
+    }
+    for (unsigned i=0; i<rainScheduleStep.size(); i++)
+    {
+	if (rainScheduleStep[i] > step && rainScheduleRate[i] > 0)
+	{
+	    return std::min(rainScheduleStep[i], no_of_iterations);
+	}
+    }
+    return no_of_iterations;
+}
+
+
+// Last step of the whole run at which the rain schedule or a reach
+// inflow hydrograph changes the water input (0 if they never do);
+// from then on the input stays the same until the end
+unsigned CatchmentParameters::lastForcingChangeStep() const
+{
+    unsigned last = 0;
+    for (unsigned scheduleStep : rainScheduleStep)
+    {
+	last = std::max(last, scheduleStep);
+    }
+    for (const vector<double>& times : reachInflowTime)
+    {
+	if (times.size() > 1 && times.back() > 0.0)
+	{
+	    last = std::max(last, static_cast<unsigned>(std::ceil(times.back() / timestep)));
+	}
+    }
+    return last;
+}
+
+
 void CatchmentParameters::notifyUser(string notification, string value)
 {
    if(LibGeoDecomp::MPILayer().rank() == 0)
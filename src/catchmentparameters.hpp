@@ -24,18 +24,52 @@ public:
     void setUnsignedIntegerParameter(unsigned& parameter, string name, string value);
     
     void setDoubleParameter(double& parameter, string name, string value);
+
+    void readEventList(string event_list_filename);
+
+    void readRainSchedule(string rain_schedule_filename);
+
+    double rainRateAtStep(unsigned step) const;
+
+    unsigned nextRainStep(unsigned step) const;
+
+    unsigned lastForcingChangeStep() const;
+
+    void readReachInflows(string reach_inflow_filename);
+
+    void readGrainSizes(string grain_size_filename);
+
+    double reachDischarge(unsigned point, double time) const;
     
 
+
     // Numerical parameters
     string simulator;
     unsigned no_of_iterations;
     double timestep;
     unsigned progress_interval=1;
+
+    // Early termination (checked every convergence_check_interval
+    // steps, disabled when zero). The changes in water depth are
+    // between two checks, divided by the steps between them, so they
+    // are mean rates of change per step rather than the largest change
+    // within a single step. A tolerance that is not set (negative) is
+    // not checked; with neither set there is no steady state stop.
+    unsigned convergence_check_interval=0;
+    double steady_state_tolerance_linf=-1.0; // max over cells of the change in water depth (m/step)
+    double steady_state_tolerance_l2=-1.0; // rms over cells of the change in water depth (m/step)
+    double dry_volume_threshold=0.0; // total water volume (m^3)
+
+    // Batch mode: each event is a parameter file whose values
+    // (rain rate, no_of_iterations, initial conditions...) override
+    // the ones above for one run on the already loaded catchment
+    vector<string> eventParameterFiles;
     
     // Inputs
     vector<GridQuantity> inputNetCDFGridQuantities;
     vector<string> inputNetCDFFileName;
     vector<string> inputNetCDFVariableName;
+    string inputRasterFileName; // DEM read directly from .asc, .flt or .bil, instead of netCDF
     bool inundate_below_elevation = false;
     double init_waterLevel;
     bool inundate_above_elevation = false;
@@ -44,12 +78,29 @@ public:
     bool rain_in_high_places = false;
     double physicalRainRate; // (mm/hour)
     double rain_above_elevation; // metres of elevation above which to rain
-    double DX, DY; // should read these from netCDF metadata if available
-    double no_data_value;
+    vector<unsigned> rainScheduleStep; // steps at which the rain rate changes...
+    vector<double> rainScheduleRate; // ...and the rain rate from then on (mm/hour)
+    string inputRainNetCDFFileName; // gridded rainfall (mm/hour), replaces rain_rate and the rain schedule
+    string inputRainNetCDFVariableName = "rainfall";
+    double rain_netcdf_interval = 0.0; // seconds between rain frames
+    double rain_grid_cellsize = 0.0; // metres
+    double rain_grid_x_offset = 0.0; // metres from the model grid corner to the rain grid corner
+    double rain_grid_y_offset = 0.0;
+    vector<int> reachInflowX; // grid cells of the reach inflow points...
+    vector<int> reachInflowY;
+    vector<vector<double>> reachInflowTime; // ...and their hydrographs: times (s)...
+    vector<vector<double>> reachInflowDischarge; // ...and discharges (m^3/s)
+    bool topmodel_runoff = false; // rain turned into runoff by TOPMODEL instead of added directly
+    double topmodel_m = 0.005; // TOPMODEL m value (m)
+    bool fast_forward_dry_periods = false;
+    double DX, DY; // set from the header when reading a raster DEM, should read these from netCDF metadata if available
+    double no_data_value = -9999.0; // elevation of cells outside the DEM, set from the header of a raster DEM
     
     // Outputs
     vector<GridQuantity> outputNetCDFGridQuantities;
     vector<int> outputNetCDFInterval;
+    string performance_report_file; // prefix of performance summary files, none if empty
+    unsigned performance_snapshot_interval=0;
     
     // Hydrology
     double edgeslope;
@@ -58,6 +109,15 @@ public:
     double mannings;
     double froudeLimit;
     double waterDepthErosionThreshold;
+
+    // Sediment
+    bool hydro_model_only = true; // no erosion
+    bool wilcock = true; // transport law: Wilcock and Crowe, otherwise Einstein
+    double max_tau_velocity = 5.0; // (m/s)
+    double active_layer_thickness = 0.2; // (m)
+    double erosion_limit = 0.05; // per cell and timestep (m)
+    vector<double> grainSizes = { 0.000065, 0.001, 0.002, 0.004, 0.008, 0.016, 0.032, 0.064, 0.128 }; // (m)
+    vector<double> grainProportions = { 0.05, 0.05, 0.15, 0.225, 0.25, 0.1, 0.075, 0.05, 0.05 };
     
     // for testing & development
     int xmax;
@@ -10,14 +10,25 @@
 double Cell::timestep = 0.0;
 double Cell::DX = 0.0;
 double Cell::DY = 0.0;
-double Cell::no_data_value = 0.0;
+double Cell::no_data_value = -9999.0;
 double Cell::edgeslope = 0.0;
 double Cell::hflowThreshold = 0.0;
 double Cell::mannings = 0.0;
+double Cell::frictionExponent = 10.0 / 3.0;
 double Cell::froudeLimit = 0.0;
 double Cell::waterDepthErosionThreshold = 0.0;
 bool Cell::rain_in_high_places = false;
 double Cell::rain_above_elevation = 0.0;
+bool Cell::topmodel = false;
+double Cell::topmodelM = 0.0;
+std::vector<double> Cell::zoneRunoff;
+bool Cell::erosion = false;
+bool Cell::wilcock = true;
+double Cell::maxTauVelocity = 0.0;
+double Cell::activeLayerThickness = 0.0;
+double Cell::erosionLimit = 0.0;
+double Cell::grainSize[Cell::grainClasses] = {};
+double Cell::grainProportion[Cell::grainClasses] = {};
 double Cell::waterOut = 0.0;
 double Cell::courantNumber = 0.0;
 const double Cell::gravity = 9.8;
@@ -28,12 +39,28 @@ void Cell::grid(LibGeoDecomp::GridBase<Cell, 2> *localGrid, const LibGeoDecomp::
     Cell::timestep = parameters.timestep;
     Cell::DX = parameters.DX;
     Cell::DY = parameters.DY;
+    Cell::no_data_value = parameters.no_data_value;
     Cell::edgeslope = parameters.edgeslope;
     Cell::hflowThreshold = parameters.hflowThreshold;
     Cell::courantNumber = parameters.courantNumber;
     Cell::mannings = parameters.mannings;
     Cell::froudeLimit = parameters.froudeLimit;
     Cell::waterDepthErosionThreshold = parameters.waterDepthErosionThreshold;
+    Cell::rain_in_high_places = parameters.rain_in_high_places;
+    Cell::topmodel = parameters.topmodel_runoff;
+    Cell::topmodelM = parameters.topmodel_m;
+    Cell::zoneRunoff.clear();
+    Cell::erosion = !parameters.hydro_model_only;
+    Cell::wilcock = parameters.wilcock;
+    Cell::maxTauVelocity = parameters.max_tau_velocity;
+    Cell::activeLayerThickness = parameters.active_layer_thickness;
+    Cell::erosionLimit = parameters.erosion_limit;
+    for (int n = 0; n < Cell::grainClasses; n++)
+    {
+	Cell::grainSize[n] = parameters.grainSizes[n];
+	Cell::grainProportion[n] = parameters.grainProportions[n];
+    }
+    Cell::waterOut = 0.0;
         
     // Set cell types (edge, corner, etc.) for all cells in local grid
     Cell::CellType celltype; 
@@ -67,7 +94,12 @@ void Cell::grid(LibGeoDecomp::GridBase<Cell, 2> *localGrid, const LibGeoDecomp::
 	    {
 		Cell cell = localGrid->get(coordinate);
 				
-		// Set grid quantities
+		// Set grid quantities; cells without an elevation in
+		// the DEM take no part in the simulation
+		if (cell.elevation == parameters.no_data_value)
+		{
+		    celltype = Cell::NODATA;
+		}
 		cell.celltype = celltype;
 		cell.celltype_double = static_cast<double>(celltype);
 		cell.rainRate = numericalRainRate(parameters.physicalRainRate);
@@ -78,7 +110,7 @@ void Cell::grid(LibGeoDecomp::GridBase<Cell, 2> *localGrid, const LibGeoDecomp::
 		// not mutually exclusive
 
 		// Set uniform inundation up to a certain elevation
-		if(parameters.inundate_below_elevation)
+		if(parameters.inundate_below_elevation && celltype != Cell::NODATA)
 		{
 		    if(cell.elevation < parameters.init_waterLevel)
 		    {
@@ -104,6 +136,21 @@ void Cell::grid(LibGeoDecomp::GridBase<Cell, 2> *localGrid, const LibGeoDecomp::
 		    cell.rain_above_elevation = parameters.rain_above_elevation;
 		}
 		
+		// Active layer of the initial bed composition, unless
+		// restored from a saved state
+		if(Cell::erosion)
+		{
+		    double thickness = 0.0;
+		    for (int n = 0; n < Cell::grainClasses; n++)
+		    {
+			thickness += cell.grain[n];
+		    }
+		    if(thickness == 0.0)
+		    {
+			cell.replenishActiveLayer();
+		    }
+		}
+		
 		// Always set water level (elevation of water surface) 
 		if(cell.waterDepth > 0)
 		{
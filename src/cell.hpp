@@ -6,6 +6,8 @@ class CatchmentParameters;
 class Cell;
 class Typemaps;
 
+#include <vector>
+
 #include <libgeodecomp/misc/apitraits.h>
 #include <libgeodecomp/storage/gridbase.h>
 #include <typemaps.h> // autogenerated from below Cell class definition by "make typemaps"
@@ -44,6 +46,16 @@ public:
 	CORNER_SW=8,
 	NODATA=9,
     };
+
+    // Neighbours that sediment is moved to
+    enum Direction : int {
+	EAST=0,
+	NORTH=1,
+	WEST=2,
+	SOUTH=3,
+    };
+
+    static const int grainClasses = 9;
     
     //+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
     // Grid quantities (each cell has its own copy)
@@ -58,6 +70,16 @@ public:
     double hflowX = 0.0;
     double hflowY = 0.0;
     double rainRate = 0.0;
+    double hydroIndex = 0.0; // TOPMODEL zone (1, 2...), 0 for runoff computed per cell
+    double runoffJ = 0.000000001; // TOPMODEL subsurface flow (m/s)
+    double inflowRate = 0.0; // reach inflow (m/timestep), set by the ReachInflowSteerer
+
+    // Sediment, in fixed size arrays rather than through an index map.
+    // Keep these last: without erosion update() copies only the
+    // members in front of grain, and the halo exchange skips them
+    double grain[grainClasses] = {}; // active layer thickness of each grain size class (m)
+    double entrained[grainClasses] = {}; // bedload leaving the cell this step (m)...
+    double sedimentShare[4] = {}; // ...and the share of it moving to each Direction
     
     //+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
     // static parameters (each MPI rank has its own copy)
@@ -70,10 +92,21 @@ public:
     static double hflowThreshold;
     static double courantNumber;
     static double mannings;
+    static double frictionExponent; // of the flow depth in the friction term, 10/3
     static double froudeLimit;
     static double waterDepthErosionThreshold;
     static bool rain_in_high_places;
     static double rain_above_elevation;
+    static bool topmodel;
+    static double topmodelM;
+    static std::vector<double> zoneRunoff; // per TOPMODEL zone (m/timestep), set by the TopmodelSteerer
+    static bool erosion;
+    static bool wilcock; // Wilcock and Crowe transport law, otherwise Einstein
+    static double maxTauVelocity;
+    static double activeLayerThickness;
+    static double erosionLimit;
+    static double grainSize[grainClasses]; // (m)
+    static double grainProportion[grainClasses];
     static double waterOut;
     static const double gravity;
     
@@ -88,6 +121,9 @@ public:
 
     // Hydrology (defined in hydrology.tpp)
     template<typename COORD_MAP> inline void catchmentWaterInputs(const COORD_MAP& neighborhood);
+    template<typename COORD_MAP> inline void topmodelWaterInputs(const COORD_MAP& neighborhood);
+    static inline double topmodelRunoff(double rain, double& j, double dt);
+    inline double rainfall() const;
     template<typename COORD_MAP> inline void flowRoute(const COORD_MAP& neighborhood);
     template<typename COORD_MAP> inline void flowRouteX(const COORD_MAP& neighborhood);
     template<typename COORD_MAP> inline void flowRouteY(const COORD_MAP& neighborhood);
@@ -102,6 +138,14 @@ public:
     inline double CFLCondition();
     template<typename COORD_MAP> inline void waterFluxOut(const COORD_MAP& neighborhood);
     static inline double numericalRainRate(const double physicalRainRate);
+
+    // Sediment (defined in sediment.tpp)
+    template<typename COORD_MAP> inline void erode(const COORD_MAP& neighborhood);
+    template<typename COORD_MAP> inline void deposit(const COORD_MAP& neighborhood);
+    inline double transportCapacity(int n, double tau, double d_50, double Fs, double grainTotal) const;
+    inline double d50() const;
+    inline double sandFraction() const;
+    inline void replenishActiveLayer();
 };
 
 
@@ -0,0 +1,122 @@
+#include <convergencesteerer.hpp>
+
+#include <libgeodecomp/communication/mpilayer.h>
+
+
+ConvergenceSteerer::ConvergenceSteerer(const CatchmentParameters& parameters, unsigned rainEndStep) :
+    LibGeoDecomp::Steerer<Cell>(parameters.convergence_check_interval),
+    toleranceLinf(parameters.steady_state_tolerance_linf),
+    toleranceL2(parameters.steady_state_tolerance_l2),
+    dryVolumeThreshold(parameters.dry_volume_threshold),
+    lastForcingStep(std::max(parameters.lastForcingChangeStep(), rainEndStep)),
+    cellArea(parameters.DX * parameters.DY),
+    index(0),
+    havePrevious(false),
+    maxChange(0.0),
+    sumSquaredChange(0.0),
+    volume(0.0),
+    cellCount(0.0)
+{
+    // The rain rate and inflows from the last change to the end of the
+    // run (gridded rainfall replaces the rain rate, and is dry after
+    // its last frame); TOPMODEL stores keep draining into the catchment
+    waterInput = parameters.topmodel_runoff
+	|| (parameters.rain_in_high_places && parameters.inputRainNetCDFFileName.empty()
+	    && parameters.rainRateAtStep(lastForcingStep) > 0);
+    for (const vector<double>& discharges : parameters.reachInflowDischarge)
+    {
+	waterInput = waterInput || discharges.back() > 0.0;
+    }
+}
+
+
+
+void ConvergenceSteerer::nextStep(
+    GridType *grid,
+    const LibGeoDecomp::Region<2>& validRegion,
+    const CoordType& globalDimensions,
+    unsigned step,
+    LibGeoDecomp::SteererEvent event,
+    std::size_t rank,
+    bool lastCall,
+    LibGeoDecomp::SteererFeedback *feedback)
+{
+    if (event != LibGeoDecomp::STEERER_NEXT_STEP)
+    {
+	return;
+    }
+    
+    // Accumulate local contributions from this part of the grid
+    for (LibGeoDecomp::Region<2>::Iterator i = validRegion.begin(); i != validRegion.end(); ++i)
+    {
+	double waterDepth = grid->get(*i).waterDepth;
+
+	if (havePrevious)
+	{
+	    double change = std::abs(waterDepth - previousWaterDepth[index]);
+	    maxChange = std::max(maxChange, change);
+	    sumSquaredChange += change * change;
+	    previousWaterDepth[index] = waterDepth;
+	}
+	else
+	{
+	    previousWaterDepth.push_back(waterDepth);
+	}
+	
+	volume += std::max(waterDepth, 0.0) * cellArea;
+	cellCount += 1.0;
+	++index;
+    }
+
+    if (!lastCall)
+    {
+	return;
+    }
+
+    // All local cells seen for this step, so reduce across ranks
+    double localSums[3] = { sumSquaredChange, volume, cellCount };
+    double globalSums[3];
+    double globalMaxChange;
+    MPI_Allreduce(&maxChange, &globalMaxChange, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce(localSums, globalSums, 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+    double linf = globalMaxChange / getPeriod();
+    double l2 = std::sqrt(globalSums[0] / globalSums[2]) / getPeriod();
+    double totalVolume = globalSums[1];
+    
+    // Only once the whole interval since the previous check is after
+    // the last change of the forcing
+    bool forcingDone = step >= lastForcingStep + getPeriod();
+
+    // Negative tolerances are not set, and not checked
+    bool steady = forcingDone && havePrevious && (toleranceLinf >= 0.0 || toleranceL2 >= 0.0)
+	&& (toleranceLinf < 0.0 || linf <= toleranceLinf)
+	&& (toleranceL2 < 0.0 || l2 <= toleranceL2);
+    bool dry = forcingDone && !waterInput && totalVolume <= dryVolumeThreshold;
+
+    if (steady || dry)
+    {
+	if (LibGeoDecomp::MPILayer().rank() == 0)
+	{
+	    std::cout << std::endl;
+	    if (steady)
+	    {
+		std::cout << "Steady state reached at step " << step;
+	    }
+	    else
+	    {
+		std::cout << "Catchment dried out at step " << step;
+	    }
+	    std::cout << " (mean change per step since the last check: max " << linf << " m, rms " << l2
+		      << " m; water volume " << totalVolume << " m^3)" << std::endl;
+	}
+	feedback->endSimulation();
+    }
+
+    havePrevious = true;
+    index = 0;
+    maxChange = 0.0;
+    sumSquaredChange = 0.0;
+    volume = 0.0;
+    cellCount = 0.0;
+}
@@ -0,0 +1,70 @@
+#ifndef HC_CONVERGENCESTEERER_H
+#define HC_CONVERGENCESTEERER_H
+
+#include <vector>
+
+#include <cell.hpp>
+#include <catchmentparameters.hpp>
+
+#include <libgeodecomp/io/steerer.h>
+
+
+// Ends the simulation before no_of_iterations once the water has
+// either reached a steady state or drained from the catchment.
+//
+// Every checkInterval steps the change in waterDepth since the
+// previous check is reduced across all ranks to its maximum (L-inf)
+// and root mean square (L2) over the cells, together with the total
+// volume of water on the grid. Both changes are divided by
+// checkInterval: they are the mean change per step over the interval,
+// not the largest change in any one step. The run stops when
+//   - the changes are within the steady state tolerances that are set
+//     (at least one must be), or
+//   - there is no rainfall, TOPMODEL runoff or reach inflow and the
+//     volume is below the dry threshold,
+// but never before the last change of the water input: of the rain
+// schedule, of a reach inflow hydrograph, or the end of the last frame
+// of gridded rainfall. A catchment that is steady or dry before the
+// rain starts (or between two rain periods) would otherwise end the
+// run and lose the rest of the rain.
+class ConvergenceSteerer : public LibGeoDecomp::Steerer<Cell>
+{
+public:
+    typedef LibGeoDecomp::Steerer<Cell>::GridType GridType;
+    typedef LibGeoDecomp::Steerer<Cell>::CoordType CoordType;
+
+    // rainEndStep is the step from which gridded rainfall (if any) is dry
+    ConvergenceSteerer(const CatchmentParameters& parameters, unsigned rainEndStep = 0);
+
+    void nextStep(
+	GridType *grid,
+	const LibGeoDecomp::Region<2>& validRegion,
+	const CoordType& globalDimensions,
+	unsigned step,
+	LibGeoDecomp::SteererEvent event,
+	std::size_t rank,
+	bool lastCall,
+	LibGeoDecomp::SteererFeedback *feedback);
+
+private:
+    double toleranceLinf;
+    double toleranceL2;
+    double dryVolumeThreshold;
+    unsigned lastForcingStep; // see CatchmentParameters::lastForcingChangeStep
+    bool waterInput; // once the forcing no longer changes
+    double cellArea;
+
+    // waterDepth of the local cells at the previous check, in region
+    // iteration order (which is fixed for a given partition)
+    std::vector<double> previousWaterDepth;
+    std::size_t index;
+    bool havePrevious;
+    
+    // Local partial sums accumulated over calls within one step
+    double maxChange;
+    double sumSquaredChange;
+    double volume;
+    double cellCount;
+};
+
+#endif
@@ -23,7 +23,8 @@ enum GridQuantity : int {
     hflowX=5,
     hflowY=6,
     celltype_double=7,
-    Max=celltype_double
+    hydroIndex=8,
+    Max=hydroIndex
 };
 
 
@@ -33,7 +34,7 @@ static const int maxGridQuantities()
 }
 
 
-static const std::vector<std::string> gridQuantityString = { "elevation", "waterDepth", "waterLevel", "qX", "qY", "hflow", "celltype" };
+static const std::vector<std::string> gridQuantityString = { "elevation", "waterDepth", "waterLevel", "qX", "qY", "hflow", "hflowY", "celltype", "hydroIndex" };
 
 
 // Selectors need to be provided to LibGeoDecomp, within which
@@ -46,7 +47,8 @@ static const std::vector<LibGeoDecomp::Selector<Cell>> gridQuantitySelectors = {
     LibGeoDecomp::Selector<Cell>(&Cell::qY, "qY"),
     LibGeoDecomp::Selector<Cell>(&Cell::hflowX, "hflowX"),
     LibGeoDecomp::Selector<Cell>(&Cell::hflowY, "hflowY"),
-    LibGeoDecomp::Selector<Cell>(&Cell::celltype_double, "celltype")
+    LibGeoDecomp::Selector<Cell>(&Cell::celltype_double, "celltype"),
+    LibGeoDecomp::Selector<Cell>(&Cell::hydroIndex, "hydroIndex")
 };
 
 
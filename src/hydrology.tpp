@@ -6,14 +6,81 @@
 template<typename COORD_MAP>
 void Cell::catchmentWaterInputs(const COORD_MAP& neighborhood) 
 {
-    // uniform persistent rainfall
-    if(rain_in_high_places)
+    if(topmodel)
     {
-	if(here.elevation >= rain_above_elevation)
+	topmodelWaterInputs(neighborhood);
+    }
+    else
+    {
+	// uniform persistent rainfall
+	waterDepth = here.waterDepth + here.rainfall();
+    }
+
+    // discharge of a reach inflow point in this cell, if any
+    waterDepth += here.inflowRate;
+}
+
+
+// Rain falling on this cell in one timestep (m)
+double Cell::rainfall() const
+{
+    if(rain_in_high_places && elevation >= rain_above_elevation)
+    {
+	return rainRate;
+    }
+    return 0.0;
+}
+
+
+// Add the runoff generated by TOPMODEL saturation excess instead of
+// the rain itself. Cells of a hydrological zone all get the runoff of
+// the zone, computed from its mean rainfall by the TopmodelSteerer;
+// other cells compute their own from their own rainfall, so that no
+// extra halo exchange is needed either way.
+//
+// This differs from LSDCatchmentModel, which puts all the runoff of a
+// zone on its catchment input points, the cells whose D8 drainage area
+// (times 3 * baseflow) falls between MIN_Q and MIN_Q_MAXVAL. Finding
+// those needs a flow accumulation over the whole grid, redone whenever
+// the baseflow changes, which a stencil update cannot provide. Spreading
+// the runoff evenly over the zone adds the same volume per step; it
+// reaches the channels by overland flow instead of directly.
+template<typename COORD_MAP>
+void Cell::topmodelWaterInputs(const COORD_MAP& neighborhood)
+{
+    unsigned zone = static_cast<unsigned>(here.hydroIndex);
+    if(zone > 0)
+    {
+	if(zone < zoneRunoff.size())
 	{
-	    waterDepth = here.waterDepth + rainRate;
+	    waterDepth = here.waterDepth + zoneRunoff[zone];
 	}
+	return;
+    }
+
+    double runoffRate = topmodelRunoff(here.rainfall() / timestep, runoffJ, timestep);
+    waterDepth = here.waterDepth + runoffRate * timestep;
+}
+
+
+// TOPMODEL saturation excess as in LSDCatchmentModel::topmodel_runoff,
+// over a step of dt seconds with rain (m/s). Updates the subsurface
+// flow j (m/s) and returns the mean runoff rate over the step (m/s).
+double Cell::topmodelRunoff(double rain, double& j, double dt)
+{
+    double jo = j;
+    double jMean;
+    if(rain > 0)
+    {
+	j = rain / (((rain - jo) / jo) * std::exp(-rain * dt / topmodelM) + 1);
+	jMean = (topmodelM / dt) * std::log(((rain - jo) + jo * std::exp(rain * dt / topmodelM)) / rain);
+    }
+    else
+    {
+	j = jo / (1 + (jo * dt) / topmodelM);
+	jMean = (topmodelM / dt) * std::log(1 + (jo * dt) / topmodelM);
     }
+    return std::max(jMean, 0.0);
 }
 
 
@@ -45,6 +112,11 @@ void Cell::flowRouteX(const COORD_MAP& neighborhood)
     case EDGE_NORTH: // excludes Northern corners
     case EDGE_SOUTH: // excludes Southern corners
     {
+	if (west.celltype == NODATA) // no flow to or from a NODATA neighbour, as in HAIL-CAESAR
+	{
+	    qX = 0.0;
+	    return;
+	}
 	west_elevation = west.elevation; 
 	west_waterDepth = west.waterDepth; 
 	tempslope = ((west_elevation + west_waterDepth) - (here.elevation + here.waterDepth)) / DX;
@@ -63,11 +135,21 @@ void Cell::flowRouteX(const COORD_MAP& neighborhood)
     case CORNER_NE:
     case CORNER_SE:
     {
+	if (west.celltype == NODATA)
+	{
+	    qX = 0.0;
+	    return;
+	}
 	west_elevation = west.elevation; 
 	west_waterDepth = west.waterDepth; 
 	tempslope = edgeslope; // corresponds to x == imax in original HAIL-CAESAR code
 	break;
     }
+    case NODATA:
+    {
+	qX = 0.0;
+	return;
+    }
     default:
 	std::cout << "\n\n WARNING: no x-direction flow route rule specified for cell type " << static_cast<int>(celltype) << "\n\n";
 	break;
@@ -115,6 +197,11 @@ void Cell::flowRouteY(const COORD_MAP& neighborhood)
     case EDGE_WEST: // excludes Western corners
     case EDGE_EAST: // excludes Eastern corners
     {
+	if (south.celltype == NODATA) // no flow to or from a NODATA neighbour, as in HAIL-CAESAR
+	{
+	    qY = 0.0;
+	    return;
+	}
 	south_elevation = south.elevation;
 	south_waterDepth = south.waterDepth;
 	tempslope = ((south_elevation + south_waterDepth) - (here.elevation + here.waterDepth)) / DY;
@@ -133,11 +220,21 @@ void Cell::flowRouteY(const COORD_MAP& neighborhood)
     case CORNER_NW:
     case CORNER_NE:
     {
+	if (south.celltype == NODATA)
+	{
+	    qY = 0.0;
+	    return;
+	}
 	south_elevation = south.elevation;
 	south_waterDepth = south.waterDepth;
 	tempslope = 0.0 - edgeslope; // corresponds to y == 1 in original HAIL-CAESAR code
 	break;
     }
+    case NODATA:
+    {
+	qY = 0.0;
+	return;
+    }
     default:
 	std::cout << "\n\n WARNING: no y-direction flow route rule specified for cell type " << static_cast<int>(celltype) << "\n\n";
 	break;
@@ -179,7 +276,7 @@ void Cell::updateQy(const COORD_MAP& neighborhood, const double hflowY, const do
 
 void Cell::updateQ(const double &q, double &q_new, const double hflow, const double tempslope, const double flowTimestep)
 {
-    q_new = ((q - (gravity * hflow * flowTimestep * tempslope)) / (1.0 + gravity * hflow * flowTimestep * (mannings * mannings) * std::abs(q) / std::pow(hflow, (10.0 / 3.0))));
+    q_new = ((q - (gravity * hflow * flowTimestep * tempslope)) / (1.0 + gravity * hflow * flowTimestep * (mannings * mannings) * std::abs(q) / std::pow(hflow, frictionExponent)));
 
 }
     
@@ -0,0 +1,53 @@
+#ifndef HC_LOCALGRIDCACHE_H
+#define HC_LOCALGRIDCACHE_H
+
+#include <vector>
+
+#include <cell.hpp>
+
+#include <libgeodecomp/geometry/coordbox.h>
+#include <libgeodecomp/storage/gridbase.h>
+
+
+// Local subgrid as read from the input file(s), kept so that
+// successive simulations on the same catchment (batch mode) restore
+// it from memory instead of re-reading the input on every event
+struct LocalGridCache
+{
+    LibGeoDecomp::CoordBox<2> boundingBox;
+    LibGeoDecomp::Coord<2> globalDimensions;
+    std::vector<Cell> cells;
+
+    // Same catchment and same partitioning as a previous run: restore
+    // the grid values as originally read, which also resets all
+    // dynamic state (water depth, discharges etc.)
+    bool restore(LibGeoDecomp::GridBase<Cell, 2> *localGrid, LibGeoDecomp::Coord<2>& dimensions) const
+    {
+	LibGeoDecomp::CoordBox<2> localBoundingBox = localGrid->boundingBox();
+	if (cells.empty() || !(boundingBox == localBoundingBox))
+	{
+	    return false;
+	}
+
+	dimensions = globalDimensions;
+	std::vector<Cell>::const_iterator cell = cells.begin();
+	for (LibGeoDecomp::CoordBox<2>::Iterator i = localBoundingBox.begin(); i != localBoundingBox.end(); ++i)
+	{
+	    localGrid->set(*i, *cell++);
+	}
+	return true;
+    }
+
+    void store(const LibGeoDecomp::GridBase<Cell, 2> *localGrid, const LibGeoDecomp::Coord<2>& dimensions)
+    {
+	boundingBox = localGrid->boundingBox();
+	globalDimensions = dimensions;
+	cells.clear();
+	for (LibGeoDecomp::CoordBox<2>::Iterator i = boundingBox.begin(); i != boundingBox.end(); ++i)
+	{
+	    cells.push_back(localGrid->get(*i));
+	}
+    }
+};
+
+#endif
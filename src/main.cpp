@@ -53,13 +53,15 @@ int main(int argc, char *argv[])
     
     std::string parameterFile = argv[1];
     Simulation simulation(parameterFile);
-    simulation.prepareInitializer();
-    simulation.prepareSimulator();
-    simulation.addWriters();
 
-    LibGeoDecomp::MPILayer().barrier();
-    
-    simulation.run();
+    if (simulation.parameters.eventParameterFiles.empty())
+    {
+	simulation.runSimulation();
+    }
+    else
+    {
+	simulation.runEvents();
+    }
     
     MPI_Finalize();  
     return 0;
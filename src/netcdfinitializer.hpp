@@ -2,18 +2,30 @@
 #define HC_NETCDFINITIALIZER_H
 
 #include <catchmentparameters.hpp>
+#include <localgridcache.hpp>
 #include <libgeodecomp/io/pnetcdfinitializer.h>
 
+
 class NetCDFInitializer : public LibGeoDecomp::PnetCDFInitializer<Cell>
 {
 public:
     NetCDFInitializer(const CatchmentParameters& parameters,
-		      const vector<LibGeoDecomp::netCDFSource<Cell>> netCDFSources);
+		      const vector<LibGeoDecomp::netCDFSource<Cell>> netCDFSources,
+		      LocalGridCache *gridCache = 0,
+		      unsigned firstStep = 0);
     
     void grid(LibGeoDecomp::GridBase<Cell, 2> *localGrid);
+
+    // Step the simulation starts from, when resuming after a dry period
+    unsigned startStep() const
+    {
+	return firstStep;
+    }
     
 private:
     CatchmentParameters parameters;
+    LocalGridCache *gridCache;
+    unsigned firstStep;
 
 };
 
@@ -0,0 +1,162 @@
+#include <performancewriter.hpp>
+
+#include <fstream>
+#include <iomanip>
+
+#include <libgeodecomp/communication/mpilayer.h>
+
+
+PerformanceWriter::PerformanceWriter(const std::string& fileName, unsigned period) :
+    LibGeoDecomp::ParallelWriter<Cell>(fileName, period),
+    fileName(fileName),
+    lastTime(MPI_Wtime()),
+    lastStep(0),
+    localCells(0.0),
+    localWetCells(0.0)
+{}
+
+
+
+void PerformanceWriter::stepFinished(
+    const GridType& grid,
+    const LibGeoDecomp::Region<2>& validRegion,
+    const LibGeoDecomp::Coord<2>& globalDimensions,
+    unsigned step,
+    LibGeoDecomp::WriterEvent event,
+    std::size_t rank,
+    bool lastCall)
+{
+    for (LibGeoDecomp::Region<2>::Iterator i = validRegion.begin(); i != validRegion.end(); ++i)
+    {
+	localCells += 1.0;
+	if (grid.get(*i).waterDepth > 0)
+	{
+	    localWetCells += 1.0;
+	}
+    }
+
+    if (!lastCall)
+    {
+	return;
+    }
+
+    bool isRoot = LibGeoDecomp::MPILayer().rank() == 0;
+    if (event == LibGeoDecomp::WRITER_INITIALIZED)
+    {
+	if (isRoot)
+	{
+	    std::ofstream csv(fileName.c_str());
+	    csv << "step,time_per_step,"
+		<< "wet_cells_min,wet_cells_mean,wet_cells_max,wet_cells_imbalance,cell_updates_per_second" << std::endl;
+	}
+
+	// Time steps from here, not from the setup
+	lastTime = MPI_Wtime();
+	lastStep = step;
+    }
+    else if (step > lastStep)
+    {
+	double now = MPI_Wtime();
+	double timePerStep = (now - lastTime) / (step - lastStep);
+
+	double minimum, maximum, sum;
+	double cells;
+	MPI_Reduce(&localWetCells, &minimum, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+	MPI_Reduce(&localWetCells, &maximum, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	MPI_Reduce(&localWetCells, &sum, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+	MPI_Reduce(&localCells, &cells, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+	if (isRoot)
+	{
+	    double meanWetCells = sum / LibGeoDecomp::MPILayer().size();
+	    std::ofstream csv(fileName.c_str(), std::ios::app);
+	    csv << step << "," << timePerStep << ","
+		<< minimum << "," << meanWetCells << "," << maximum << ","
+		<< (meanWetCells > 0 ? maximum / meanWetCells : 1.0) << ","
+		<< cells / (timePerStep > 0 ? timePerStep : 1.0) << std::endl;
+	}
+
+	lastTime = now;
+	lastStep = step;
+    }
+
+    localCells = 0.0;
+    localWetCells = 0.0;
+}
+
+
+
+void PerformanceWriter::writeSummary(
+    const std::string& fileNamePrefix,
+    const std::vector<LibGeoDecomp::Chronometer>& statistics,
+    double wallTime,
+    double cells,
+    unsigned steps)
+{
+    if (LibGeoDecomp::MPILayer().rank() != 0 || statistics.empty())
+    {
+	return;
+    }
+
+    // Phases as timed by LibGeoDecomp: patch providers deliver
+    // incoming ghost zones (i.e. waiting for halo exchange), patch
+    // accepters send ghost zones and feed the writers
+    const std::vector<std::string> phases = { "total", "compute", "halo_wait", "output" };
+    std::vector<std::vector<double> > times(statistics.size());
+    for (std::size_t rank = 0; rank < statistics.size(); rank++)
+    {
+	times[rank] = {
+	    statistics[rank].interval<LibGeoDecomp::TimeTotal>(),
+	    statistics[rank].interval<LibGeoDecomp::TimeCompute>(),
+	    statistics[rank].interval<LibGeoDecomp::TimePatchProviders>(),
+	    statistics[rank].interval<LibGeoDecomp::TimePatchAccepters>() };
+    }
+
+    std::ofstream csv((fileNamePrefix + "_ranks.csv").c_str());
+    csv << "rank";
+    for (const std::string& phase : phases)
+    {
+	csv << "," << phase;
+    }
+    csv << std::endl;
+    for (std::size_t rank = 0; rank < times.size(); rank++)
+    {
+	csv << rank;
+	for (double time : times[rank])
+	{
+	    csv << "," << time;
+	}
+	csv << std::endl;
+    }
+
+    std::ofstream json((fileNamePrefix + ".json").c_str());
+    json << std::setprecision(6);
+    json << "{" << std::endl;
+    json << "  \"ranks\": " << times.size() << "," << std::endl;
+    json << "  \"steps\": " << steps << "," << std::endl;
+    json << "  \"cells\": " << cells << "," << std::endl;
+    json << "  \"wall_time\": " << wallTime << "," << std::endl;
+    json << "  \"cell_updates_per_second\": " << (wallTime > 0 ? cells * steps / wallTime : 0.0);
+    for (std::size_t phase = 0; phase < phases.size(); phase++)
+    {
+	double minimum = times[0][phase];
+	double maximum = times[0][phase];
+	double sum = 0.0;
+	for (std::size_t rank = 0; rank < times.size(); rank++)
+	{
+	    minimum = std::min(minimum, times[rank][phase]);
+	    maximum = std::max(maximum, times[rank][phase]);
+	    sum += times[rank][phase];
+	}
+	double mean = sum / times.size();
+
+	json << "," << std::endl;
+	json << "  \"" << phases[phase] << "\": { \"min\": " << minimum
+	     << ", \"mean\": " << mean
+	     << ", \"max\": " << maximum
+	     << ", \"imbalance\": " << (mean > 0 ? maximum / mean : 1.0) << " }";
+    }
+    json << std::endl << "}" << std::endl;
+
+    std::cout << "Performance summary written to " << fileNamePrefix << ".json" << std::endl;
+}
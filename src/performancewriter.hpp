@@ -0,0 +1,65 @@
+#ifndef HC_PERFORMANCEWRITER_H
+#define HC_PERFORMANCEWRITER_H
+
+#include <string>
+#include <vector>
+
+#include <cell.hpp>
+
+#include <libgeodecomp/io/parallelwriter.h>
+#include <libgeodecomp/misc/chronometer.h>
+
+
+// Performance instrumentation.
+//
+// As a writer, appends a line to a CSV file on rank 0 every period
+// steps, with the wall time per step since the previous line (the
+// ranks wait for each other's halos, so it is the same on every rank),
+// the minimum, mean and maximum across ranks of the number of wet
+// cells (the work that actually varies between ranks), and the overall
+// cell update rate. The first interval starts once the grid is
+// initialised, so it does not include the setup time.
+//
+// writeSummary() reports the per-rank timings LibGeoDecomp keeps in
+// its Chronometer for the whole run (compute and halo wait time of
+// each rank, which do show stragglers), as JSON (min/mean/max/imbalance
+// across ranks) and CSV (one line per rank).
+class PerformanceWriter : public LibGeoDecomp::ParallelWriter<Cell>
+{
+public:
+    typedef LibGeoDecomp::ParallelWriter<Cell>::GridType GridType;
+
+    PerformanceWriter(const std::string& fileName, unsigned period);
+
+    LibGeoDecomp::ParallelWriter<Cell> *clone() const
+    {
+	return new PerformanceWriter(*this);
+    }
+
+    void stepFinished(
+	const GridType& grid,
+	const LibGeoDecomp::Region<2>& validRegion,
+	const LibGeoDecomp::Coord<2>& globalDimensions,
+	unsigned step,
+	LibGeoDecomp::WriterEvent event,
+	std::size_t rank,
+	bool lastCall);
+
+    // Writes the files on rank 0 from the statistics gathered there;
+    // does nothing on the other ranks
+    static void writeSummary(
+	const std::string& fileNamePrefix,
+	const std::vector<LibGeoDecomp::Chronometer>& statistics,
+	double wallTime,
+	double cells,
+	unsigned steps);
+
+private:
+    std::string fileName;
+    double lastTime;
+    unsigned lastStep;
+    double localCells;
+    double localWetCells;
+};
+
+#endif
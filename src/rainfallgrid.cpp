@@ -0,0 +1,321 @@
+#include <rainfallgrid.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <mpi.h>
+#include <pnetcdf.h>
+
+
+static void rainfallError(const string& message)
+{
+    std::cout << message << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+
+// Reads the layout of the rain variable on rank 0 only, to spare the
+// file system thousands of simultaneous opens of the same file
+static bool readMetadata(const string& fileName, const string& variableName,
+			 std::vector<std::uint64_t>& metadata)
+{
+    int ncid, varid, ndims, dimids[3], unlimdim;
+    nc_type type;
+    MPI_Offset length[3], offset, recsize;
+
+    int status = ncmpi_open(MPI_COMM_SELF, fileName.c_str(), NC_NOWRITE, MPI_INFO_NULL, &ncid);
+    if (status != NC_NOERR)
+    {
+	std::cout << "Could not open rainfall file " << fileName << ": " << ncmpi_strerror(status) << std::endl;
+	return false;
+    }
+
+    bool valid = false;
+    if ((status = ncmpi_inq_varid(ncid, variableName.c_str(), &varid)) != NC_NOERR)
+    {
+	std::cout << "No variable " << variableName << " in rainfall file " << fileName << std::endl;
+    }
+    else if (ncmpi_inq_varndims(ncid, varid, &ndims) != NC_NOERR || ndims != 3)
+    {
+	std::cout << "Rainfall variable " << variableName << " must have three dimensions (time, y, x)" << std::endl;
+    }
+    else if (ncmpi_inq_vartype(ncid, varid, &type) != NC_NOERR || (type != NC_FLOAT && type != NC_DOUBLE))
+    {
+	std::cout << "Rainfall variable " << variableName << " must be float or double" << std::endl;
+    }
+    else
+    {
+	ncmpi_inq_vardimid(ncid, varid, dimids);
+	for (int i = 0; i < 3; i++)
+	{
+	    ncmpi_inq_dimlen(ncid, dimids[i], &length[i]);
+	}
+	ncmpi_inq_unlimdim(ncid, &unlimdim);
+	ncmpi_inq_varoffset(ncid, varid, &offset);
+
+	std::uint64_t valueSize = (type == NC_FLOAT) ? 4 : 8;
+	std::uint64_t frameStride = length[1] * length[2] * valueSize;
+	if (dimids[0] == unlimdim)
+	{
+	    // record variable: frames are interleaved with the other record variables
+	    ncmpi_inq_recsize(ncid, &recsize);
+	    frameStride = recsize;
+	}
+
+	metadata = { std::uint64_t(length[0]), std::uint64_t(length[1]), std::uint64_t(length[2]),
+		     valueSize, std::uint64_t(offset), frameStride };
+	valid = true;
+    }
+
+    ncmpi_close(ncid);
+    return valid;
+}
+
+
+RainfallGrid::RainfallGrid(const CatchmentParameters& parameters) :
+    fileName(parameters.inputRainNetCDFFileName),
+    interval(parameters.rain_netcdf_interval),
+    cellSize(parameters.rain_grid_cellsize),
+    xOffset(parameters.rain_grid_x_offset),
+    yOffset(parameters.rain_grid_y_offset),
+    DX(parameters.DX),
+    DY(parameters.DY),
+    currentFrame(0),
+    nextFrame(0)
+{
+    if (interval <= 0.0 || cellSize <= 0.0)
+    {
+	rainfallError("Gridded rainfall needs rain_netcdf_interval and rain_grid_cellsize");
+    }
+
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::vector<std::uint64_t> metadata(6, 0);
+    int valid = 1;
+    if (rank == 0)
+    {
+	valid = readMetadata(fileName, parameters.inputRainNetCDFVariableName, metadata);
+    }
+    MPI_Bcast(&valid, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (!valid)
+    {
+	exit(EXIT_FAILURE);
+    }
+    MPI_Bcast(metadata.data(), metadata.size(), MPI_UINT64_T, 0, MPI_COMM_WORLD);
+
+    nt = metadata[0];
+    ny = metadata[1];
+    nx = metadata[2];
+    valueSize = metadata[3];
+    dataOffset = metadata[4];
+    frameStride = metadata[5];
+
+    if (rank == 0)
+    {
+	std::cout << "Gridded rainfall: " << nt << " frames of " << nx << " x " << ny
+		  << " cells, every " << interval << " s" << std::endl;
+    }
+}
+
+
+
+RainfallGrid::~RainfallGrid()
+{
+    if (next.valid())
+    {
+	next.wait();
+    }
+    if (file >= 0)
+    {
+	close(file);
+    }
+}
+
+
+
+unsigned RainfallGrid::frameAtTime(double time) const
+{
+    double frame = std::floor(time / interval);
+    return (frame < 0.0 || frame >= nt) ? nt : static_cast<unsigned>(frame);
+}
+
+
+
+// For each of count model cells from first: the rain cells on either
+// side of its centre and the interpolation weight, relative to the
+// first rain cell of the tile (tileFirst, tileCount rain cells)
+std::vector<RainfallGrid::Weight> RainfallGrid::weights(int first, int count, double modelCellSize, double offset, long rainCells, long& tileFirst, long& tileCount) const
+{
+    std::vector<Weight> cellWeights(count);
+    long lowest = rainCells - 1;
+    long highest = 0;
+    for (int i = 0; i < count; i++)
+    {
+	double position = ((first + i + 0.5) * modelCellSize - offset) / cellSize - 0.5;
+	long lower = static_cast<long>(std::floor(position));
+	Weight& weight = cellWeights[i];
+	if (lower < 0)
+	{
+	    weight = Weight { 0, 0, 0.0 };
+	}
+	else if (lower >= rainCells - 1)
+	{
+	    weight = Weight { int(rainCells - 1), int(rainCells - 1), 0.0 };
+	}
+	else
+	{
+	    weight = Weight { int(lower), int(lower + 1), position - lower };
+	}
+	lowest = std::min(lowest, long(weight.lower));
+	highest = std::max(highest, long(weight.upper));
+    }
+
+    tileFirst = std::min(lowest, highest);
+    tileCount = (count > 0) ? highest - lowest + 1 : 0;
+    for (Weight& weight : cellWeights)
+    {
+	weight.lower -= lowest;
+	weight.upper -= lowest;
+    }
+    return cellWeights;
+}
+
+
+
+void RainfallGrid::setLocalBox(const LibGeoDecomp::CoordBox<2>& box)
+{
+    localBox = box;
+    columnWeights = weights(box.origin.x(), box.dimensions.x(), DX, xOffset, nx, tileX, tileWidth);
+    rowWeights = weights(box.origin.y(), box.dimensions.y(), DY, yOffset, ny, tileY, tileHeight);
+
+    file = open(fileName.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+	rainfallError("Could not open rainfall file " + fileName);
+    }
+    haveLocalBox = true;
+}
+
+
+
+// Rows of the tile of one frame, converted from big endian. Missing
+// values (negative, or netCDF fill values) are dry. Runs in the
+// background, so touches nothing but the file and its own buffer;
+// read errors are thrown, for load to report on the main thread.
+std::vector<double> RainfallGrid::readTile(unsigned frame) const
+{
+    std::vector<double> tile(tileWidth * tileHeight, 0.0);
+    if (frame >= nt)
+    {
+	return tile;
+    }
+
+    std::vector<unsigned char> row(tileWidth * valueSize);
+    for (long r = 0; r < tileHeight; r++)
+    {
+	std::uint64_t offset = dataOffset + frame * frameStride + ((tileY + r) * nx + tileX) * valueSize;
+	std::uint64_t done = 0;
+	while (done < row.size())
+	{
+	    ssize_t count = pread(file, row.data() + done, row.size() - done, offset + done);
+	    if (count <= 0)
+	    {
+		throw std::runtime_error("Error reading rainfall file " + fileName);
+	    }
+	    done += count;
+	}
+
+	for (long c = 0; c < tileWidth; c++)
+	{
+	    const unsigned char *bytes = &row[c * valueSize];
+	    std::uint64_t bits = 0;
+	    for (int b = 0; b < valueSize; b++)
+	    {
+		bits = (bits << 8) | bytes[b];
+	    }
+	    double value;
+	    if (valueSize == 4)
+	    {
+		std::uint32_t bits32 = static_cast<std::uint32_t>(bits);
+		float single;
+		std::memcpy(&single, &bits32, 4);
+		value = single;
+	    }
+	    else
+	    {
+		std::memcpy(&value, &bits, 8);
+	    }
+	    tile[r * tileWidth + c] = (value > 0.0 && value < 1e30) ? value : 0.0;
+	}
+    }
+    return tile;
+}
+
+
+
+void RainfallGrid::prefetch(unsigned frame)
+{
+    nextFrame = frame;
+    next = std::async(std::launch::async, &RainfallGrid::readTile, this, frame);
+}
+
+
+
+void RainfallGrid::load(unsigned frame, const LibGeoDecomp::CoordBox<2>& box)
+{
+    if (!haveLocalBox)
+    {
+	setLocalBox(box);
+    }
+    else if (frame == currentFrame && !current.empty())
+    {
+	return;
+    }
+
+    try
+    {
+	if (next.valid() && nextFrame == frame)
+	{
+	    current = next.get(); // rethrows an error of the background read
+	}
+	else
+	{
+	    if (next.valid())
+	    {
+		next.wait(); // jumped past the prefetched frame
+		next = std::future<std::vector<double>>();
+	    }
+	    current = readTile(frame);
+	}
+    }
+    catch (const std::runtime_error& error)
+    {
+	rainfallError(error.what());
+    }
+    currentFrame = frame;
+
+    if (frame + 1 < nt)
+    {
+	prefetch(frame + 1);
+    }
+}
+
+
+
+double RainfallGrid::rate(const LibGeoDecomp::Coord<2>& cell) const
+{
+    const Weight& column = columnWeights[cell.x() - localBox.origin.x()];
+    const Weight& row = rowWeights[cell.y() - localBox.origin.y()];
+    const double *lower = &current[row.lower * tileWidth];
+    const double *upper = &current[row.upper * tileWidth];
+    double lowerRow = (1.0 - column.upperWeight) * lower[column.lower] + column.upperWeight * lower[column.upper];
+    double upperRow = (1.0 - column.upperWeight) * upper[column.lower] + column.upperWeight * upper[column.upper];
+    return (1.0 - row.upperWeight) * lowerRow + row.upperWeight * upperRow;
+}
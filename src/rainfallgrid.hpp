@@ -0,0 +1,110 @@
+#ifndef HC_RAINFALLGRID_H
+#define HC_RAINFALLGRID_H
+
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+
+#include <catchmentparameters.hpp>
+
+#include <libgeodecomp/geometry/coordbox.h>
+
+
+// Gridded rainfall (e.g. radar) from a netCDF variable with dimensions
+// (time, y, x), in mm/hour, usually much coarser than the model grid.
+// Frame t applies from t*rain_netcdf_interval to
+// (t+1)*rain_netcdf_interval seconds; after the last frame it is dry.
+//
+// The rain grid is aligned with the model grid (y index increasing in
+// the same direction), with cells of rain_grid_cellsize metres and its
+// corner at (rain_grid_x_offset, rain_grid_y_offset) metres from the
+// corner of the model grid. Rain rates are interpolated bilinearly
+// between rain cell centres onto model cell centres.
+//
+// Rank 0 reads the metadata (dimensions, type and position of the
+// variable in the file) with PnetCDF and broadcasts it. After that,
+// each rank reads only the rows of the rain tile covering its own
+// subgrid, directly from the file: the classic netCDF formats, the
+// only ones PnetCDF supports, store a variable as plain big endian
+// arrays at fixed offsets. This needs no MPI, so the next frame is
+// read in the background while the current one is in use.
+class RainfallGrid
+{
+public:
+    // Collective (all ranks must construct it together)
+    RainfallGrid(const CatchmentParameters& parameters);
+
+    ~RainfallGrid();
+
+    // Rain frame at a time (seconds since the start of the run), or
+    // frames() if it is past the last frame
+    unsigned frameAtTime(double time) const;
+
+    unsigned frames() const
+    {
+	return nt;
+    }
+
+    // Time (seconds since the start of the run) from which it is dry
+    double endTime() const
+    {
+	return nt * interval;
+    }
+
+    // Makes frame the current frame, for the cells in localBox (the
+    // same box on every call). Frame frames() is dry.
+    void load(unsigned frame, const LibGeoDecomp::CoordBox<2>& localBox);
+
+    // Rain rate (mm/hour) of the current frame at a cell of localBox
+    double rate(const LibGeoDecomp::Coord<2>& cell) const;
+
+private:
+    // Interpolation between two rain rows (or columns) of the tile
+    struct Weight
+    {
+	int lower;
+	int upper;
+	double upperWeight;
+    };
+
+    void setLocalBox(const LibGeoDecomp::CoordBox<2>& localBox);
+    std::vector<Weight> weights(int first, int count, double cellSize, double offset, long rainCells, long& tileFirst, long& tileCount) const;
+    std::vector<double> readTile(unsigned frame) const;
+    void prefetch(unsigned frame);
+
+    string fileName;
+    double interval;
+    double cellSize;
+    double xOffset;
+    double yOffset;
+    double DX;
+    double DY;
+
+    // Metadata, as read by rank 0
+    long nt = 0;
+    long ny = 0;
+    long nx = 0;
+    int valueSize = 4; // 4 for float, 8 for double
+    std::uint64_t dataOffset = 0; // of frame 0
+    std::uint64_t frameStride = 0; // bytes between frames
+
+    int file = -1;
+    bool haveLocalBox = false;
+    LibGeoDecomp::CoordBox<2> localBox;
+    long tileX = 0;
+    long tileY = 0;
+    long tileWidth = 0;
+    long tileHeight = 0;
+    std::vector<Weight> columnWeights;
+    std::vector<Weight> rowWeights;
+
+    // Double buffering: the current frame, and the next one being
+    // read in the background
+    unsigned currentFrame;
+    std::vector<double> current;
+    unsigned nextFrame;
+    std::future<std::vector<double>> next;
+};
+
+#endif
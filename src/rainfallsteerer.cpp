@@ -0,0 +1,140 @@
+#include <rainfallsteerer.hpp>
+
+#include <climits>
+#include <cmath>
+
+#include <libgeodecomp/communication/mpilayer.h>
+
+
+RainfallSteerer::RainfallSteerer(const CatchmentParameters& parameters,
+				 LocalGridCache *stateCache,
+				 bool *driedOut,
+				 unsigned *driedOutStep) :
+    LibGeoDecomp::Steerer<Cell>(1),
+    parameters(parameters),
+    checkInterval(std::max(parameters.convergence_check_interval, 1u)),
+    cellArea(parameters.DX * parameters.DY),
+    currentRate(parameters.physicalRainRate), // as set by Cell::grid()
+    rainGrid(nullptr),
+    currentFrame(UINT_MAX),
+    stateCache(stateCache),
+    driedOut(driedOut),
+    driedOutStep(driedOutStep),
+    volume(0.0)
+{
+    *driedOut = false;
+
+    if (!parameters.inputRainNetCDFFileName.empty())
+    {
+	rainGrid = new RainfallGrid(parameters);
+    }
+}
+
+
+
+RainfallSteerer::~RainfallSteerer()
+{
+    delete rainGrid;
+}
+
+
+
+unsigned RainfallSteerer::rainEndStep() const
+{
+    if (!rainGrid)
+    {
+	return 0;
+    }
+    return static_cast<unsigned>(std::ceil(rainGrid->endTime() / parameters.timestep));
+}
+
+
+
+void RainfallSteerer::nextStep(
+    GridType *grid,
+    const LibGeoDecomp::Region<2>& validRegion,
+    const CoordType& globalDimensions,
+    unsigned step,
+    LibGeoDecomp::SteererEvent event,
+    std::size_t rank,
+    bool lastCall,
+    LibGeoDecomp::SteererFeedback *feedback)
+{
+    if (event != LibGeoDecomp::STEERER_NEXT_STEP)
+    {
+	return;
+    }
+
+    if (rainGrid)
+    {
+	// Rain rates of the frame for the cells updated from the next
+	// step onwards; the next frame is already being read
+	unsigned frame = rainGrid->frameAtTime(step * parameters.timestep);
+	if (frame != currentFrame)
+	{
+	    rainGrid->load(frame, grid->boundingBox());
+	    for (LibGeoDecomp::Region<2>::Iterator i = validRegion.begin(); i != validRegion.end(); ++i)
+	    {
+		Cell cell = grid->get(*i);
+		cell.rainRate = Cell::numericalRainRate(rainGrid->rate(*i));
+		grid->set(*i, cell);
+	    }
+	    if (lastCall)
+	    {
+		currentFrame = frame;
+	    }
+	}
+	return;
+    }
+
+    // New rain rate for the cells updated from the next step onwards
+    double rate = parameters.rainRateAtStep(step);
+    if (rate != currentRate)
+    {
+	double rainRate = Cell::numericalRainRate(rate);
+	for (LibGeoDecomp::Region<2>::Iterator i = validRegion.begin(); i != validRegion.end(); ++i)
+	{
+	    Cell cell = grid->get(*i);
+	    cell.rainRate = rainRate;
+	    grid->set(*i, cell);
+	}
+	if (lastCall)
+	{
+	    currentRate = rate;
+	}
+	return;
+    }
+    
+    // TOPMODEL stores and reach inflows keep feeding the catchment
+    // while it is not raining
+    if (!parameters.fast_forward_dry_periods || parameters.topmodel_runoff || !parameters.reachInflowX.empty()
+	|| currentRate > 0 || step % checkInterval != 0)
+    {
+	return;
+    }
+
+    for (LibGeoDecomp::Region<2>::Iterator i = validRegion.begin(); i != validRegion.end(); ++i)
+    {
+	volume += std::max(grid->get(*i).waterDepth, 0.0) * cellArea;
+    }
+
+    if (!lastCall)
+    {
+	return;
+    }
+
+    double totalVolume;
+    MPI_Allreduce(&volume, &totalVolume, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    volume = 0.0;
+    
+    if (totalVolume <= parameters.dry_volume_threshold)
+    {
+	// Save the whole local grid (including ghost cells) so the
+	// next simulation starts from exactly this state
+	stateCache->store(grid, globalDimensions);
+
+	*driedOut = true;
+	*driedOutStep = step;
+	feedback->endSimulation();
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef HC_RAINFALLSTEERER_H
+#define HC_RAINFALLSTEERER_H
+
+#include <cell.hpp>
+#include <catchmentparameters.hpp>
+#include <localgridcache.hpp>
+#include <rainfallgrid.hpp>
+
+#include <libgeodecomp/io/steerer.h>
+
+
+// Applies the changes of rain rate listed in the rain schedule as the
+// simulation reaches them, or with input_rain_netcdf_file the rain
+// rates of each cell from the frames of gridded rainfall.
+//
+// With fast_forward_dry_periods, while it is not raining the total
+// water volume is also reduced across ranks every checkInterval
+// steps. Once it falls below dry_volume_threshold the local grid is
+// saved to stateCache and the simulation is ended, so that it can be
+// resumed at the next step with rain instead of stepping through the
+// dry period.
+class RainfallSteerer : public LibGeoDecomp::Steerer<Cell>
+{
+public:
+    typedef LibGeoDecomp::Steerer<Cell>::GridType GridType;
+    typedef LibGeoDecomp::Steerer<Cell>::CoordType CoordType;
+
+    RainfallSteerer(const CatchmentParameters& parameters,
+		    LocalGridCache *stateCache,
+		    bool *driedOut,
+		    unsigned *driedOutStep);
+
+    ~RainfallSteerer();
+
+    // Step from which the gridded rainfall is dry (0
+    // without gridded rainfall)
+    unsigned rainEndStep() const;
+
+    void nextStep(
+	GridType *grid,
+	const LibGeoDecomp::Region<2>& validRegion,
+	const CoordType& globalDimensions,
+	unsigned step,
+	LibGeoDecomp::SteererEvent event,
+	std::size_t rank,
+	bool lastCall,
+	LibGeoDecomp::SteererFeedback *feedback);
+
+private:
+    CatchmentParameters parameters;
+    unsigned checkInterval;
+    double cellArea;
+    double currentRate;
+    RainfallGrid *rainGrid; // gridded rainfall, if any
+    unsigned currentFrame;
+
+    // Outputs read back by the Simulation once the simulator (which
+    // owns this steerer) has been deleted
+    LocalGridCache *stateCache;
+    bool *driedOut;
+    unsigned *driedOutStep;
+    
+    double volume;
+};
+
+#endif
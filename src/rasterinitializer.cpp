@@ -0,0 +1,422 @@
+#include <rasterinitializer.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <LSDParameterParser.hpp>
+#include <rootinput.hpp>
+#include <libgeodecomp/communication/mpilayer.h>
+
+
+static void rasterError(const string& message)
+{
+    if(LibGeoDecomp::MPILayer().rank() == 0)
+    {
+	std::cout << message << std::endl;
+    }
+    exit(EXIT_FAILURE);
+}
+
+
+static string lowercase(string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    return text;
+}
+
+
+static bool littleEndian()
+{
+    const std::uint16_t one = 1;
+    return *reinterpret_cast<const unsigned char*>(&one) == 1;
+}
+
+
+// pread the whole of [offset, offset+bytes), which may take several calls
+static void readFully(int file, char *buffer, std::uint64_t bytes, std::uint64_t offset, const string& fileName)
+{
+    while (bytes > 0)
+    {
+	ssize_t count = pread(file, buffer, bytes, offset);
+	if (count <= 0)
+	{
+	    std::cout << "Error reading " << fileName << " at byte " << offset << std::endl;
+	    exit(EXIT_FAILURE);
+	}
+	buffer += count;
+	bytes -= count;
+	offset += count;
+    }
+}
+
+
+
+// ESRI ASCII header lines and ESRI .hdr files are "key value", ENVI
+// .hdr files "key = value" where keys may contain spaces
+RasterHeader RasterHeader::read(string fileName)
+{
+    RasterHeader header;
+    header.dataFileName = fileName;
+    header.format = lowercase(fileName.substr(fileName.find_last_of('.') + 1));
+    string headerFileName = (header.format == "asc") ? fileName : fileName.substr(0, fileName.find_last_of('.')) + ".hdr";
+
+    // Rank 0 reads the header (for ASCII the start of the DEM itself,
+    // the header lines are well within the first 64 kB) and all ranks
+    // parse the same contents
+    string contents;
+    if (!readOnRootAndBroadcast(headerFileName, contents, (header.format == "asc") ? 1 << 16 : UINT64_MAX))
+    {
+	rasterError("Could not open DEM header " + headerFileName);
+    }
+    std::istringstream infile(contents);
+    if (header.format != "asc" && header.format != "flt" && header.format != "bil")
+    {
+	rasterError("Unsupported DEM format " + header.format + " (expecting asc, flt or bil)");
+    }
+
+    bool envi = false;
+    bool haveDY = false;
+    bool xCenter = false;
+    bool yCenter = false;
+    string line;
+    while (std::getline(infile, line))
+    {
+	line = RemoveControlCharactersFromEndOfString(line);
+	string key, value;
+	size_t equals = line.find('=');
+	if (envi && equals != string::npos)
+	{
+	    key = line.substr(0, equals);
+	    key.erase(key.find_last_not_of(" \t") + 1);
+	    value = line.substr(equals + 1);
+	    value.erase(0, value.find_first_not_of(" \t"));
+	}
+	else
+	{
+	    std::istringstream columns(line);
+	    columns >> key;
+	    std::getline(columns >> std::ws, value);
+	}
+	key = lowercase(key);
+
+	if (key == "envi")
+	{
+	    envi = true;
+	    continue;
+	}
+	if (header.format == "asc" && !key.empty() && (isdigit(key[0]) || key[0] == '-' || key[0] == '.'))
+	{
+	    break; // first line of data
+	}
+	header.headerLines++;
+
+	if (key == "ncols" || key == "samples") header.ncols = atol(value.c_str());
+	else if (key == "nrows" || key == "lines") header.nrows = atol(value.c_str());
+	else if (key == "xllcorner" || key == "xllcenter") { header.xllcorner = atof(value.c_str()); xCenter = (key == "xllcenter"); }
+	else if (key == "yllcorner" || key == "yllcenter") { header.yllcorner = atof(value.c_str()); yCenter = (key == "yllcenter"); }
+	else if (key == "cellsize") header.DX = atof(value.c_str());
+	else if (key == "dx") header.DX = atof(value.c_str());
+	else if (key == "dy") { header.DY = atof(value.c_str()); haveDY = true; }
+	else if (key == "nodata_value" || key == "data ignore value") header.noDataValue = atof(value.c_str());
+	else if (key == "byteorder") header.swapBytes = (lowercase(value) == "msbfirst") == littleEndian();
+	else if (key == "byte order") header.swapBytes = (atoi(value.c_str()) == 1) == littleEndian();
+	else if (key == "header offset") header.headerOffset = atol(value.c_str());
+	else if (key == "data type") header.dataType = atoi(value.c_str());
+	else if (key == "map info")
+	{
+	    // {projection, reference pixel x, y, easting, northing, pixel size x, y, ...}
+	    std::vector<string> fields;
+	    std::istringstream mapInfo(value.substr(value.find('{') + 1));
+	    string field;
+	    while (std::getline(mapInfo, field, ','))
+	    {
+		fields.push_back(field);
+	    }
+	    if (fields.size() < 7)
+	    {
+		rasterError("Could not read map info from " + headerFileName);
+	    }
+	    header.DX = atof(fields[5].c_str());
+	    header.DY = atof(fields[6].c_str());
+	    haveDY = true;
+	    header.xllcorner = atof(fields[3].c_str());
+	    header.yllcorner = atof(fields[4].c_str()); // northing of top edge, corrected below
+	}
+    }
+
+    if (!haveDY)
+    {
+	header.DY = header.DX;
+    }
+    // Centre of the lower left cell, rather than its corner
+    if (xCenter)
+    {
+	header.xllcorner -= header.DX / 2;
+    }
+    if (yCenter)
+    {
+	header.yllcorner -= header.DY / 2;
+    }
+    if (envi)
+    {
+	header.yllcorner -= header.nrows * header.DY;
+    }
+    if (header.format == "flt")
+    {
+	header.dataType = 4;
+    }
+    if (header.format != "asc" && header.dataType != 2 && header.dataType != 4)
+    {
+	rasterError("Unsupported data type in " + headerFileName + " (expecting 16 bit integer or 32 bit float)");
+    }
+    if (header.ncols <= 0 || header.nrows <= 0 || header.DX <= 0.0)
+    {
+	rasterError("Could not read DEM dimensions and cell size from " + headerFileName);
+    }
+
+    return header;
+}
+
+
+
+RasterInitializer::RasterInitializer(const CatchmentParameters& parameters,
+				     LocalGridCache *gridCache,
+				     unsigned firstStep) :
+    RasterInitializer(parameters, RasterHeader::read(parameters.inputRasterFileName), gridCache, firstStep)
+{}
+
+RasterInitializer::RasterInitializer(const CatchmentParameters& parameters,
+				     const RasterHeader& header,
+				     LocalGridCache *gridCache,
+				     unsigned firstStep) :
+    LibGeoDecomp::SimpleInitializer<Cell>(LibGeoDecomp::Coord<2>(header.ncols, header.nrows), parameters.no_of_iterations),
+    parameters(parameters),
+    header(header),
+    gridCache(gridCache),
+    firstStep(firstStep)
+{
+    // Cell size from the georeferencing of the DEM, and its NODATA
+    // value, for Cell::grid to make those cells NODATA cells
+    this->parameters.DX = header.DX;
+    this->parameters.DY = header.DY;
+    this->parameters.no_data_value = header.noDataValue;
+
+    if(LibGeoDecomp::MPILayer().rank() == 0)
+    {
+	std::cout << "DEM " << header.dataFileName << ": " << header.ncols << " x " << header.nrows
+		  << " cells of " << header.DX << " x " << header.DY << " m, lower left corner ("
+		  << header.xllcorner << ", " << header.yllcorner << ")" << std::endl;
+    }
+}
+
+
+
+void RasterInitializer::grid(LibGeoDecomp::GridBase<Cell, 2> *localGrid)
+{
+    bool restored = gridCache && gridCache->restore(localGrid, dimensions);
+
+    // Indexing an ASCII file is collective, so either all ranks
+    // restore their subgrid or all read it again
+    if (header.format == "asc")
+    {
+	int localRestored = restored;
+	int allRestored;
+	MPI_Allreduce(&localRestored, &allRestored, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+	restored = allRestored;
+    }
+
+    if (!restored)
+    {
+	int file = open(header.dataFileName.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+	    std::cout << "Could not open DEM " << header.dataFileName << std::endl;
+	    exit(EXIT_FAILURE);
+	}
+
+	if (header.format == "asc")
+	{
+	    readASCIIRows(localGrid, file);
+	}
+	else
+	{
+	    readBinaryRows(localGrid, file);
+	}
+	close(file);
+
+	if (gridCache)
+	{
+	    gridCache->store(localGrid, dimensions);
+	}
+    }
+
+    // Call grid() from Cell class to initialize celltypes
+    Cell::grid(localGrid, dimensions, parameters);
+}
+
+
+
+void RasterInitializer::readBinaryRows(LibGeoDecomp::GridBase<Cell, 2> *localGrid, int file)
+{
+    LibGeoDecomp::CoordBox<2> box = localGrid->boundingBox();
+    long x0 = std::max(0, box.origin.x());
+    long x1 = std::min<long>(header.ncols, box.origin.x() + box.dimensions.x());
+    long y0 = std::max(0, box.origin.y());
+    long y1 = std::min<long>(header.nrows, box.origin.y() + box.dimensions.y());
+    if (x1 <= x0)
+    {
+	return;
+    }
+
+    const unsigned bytesPerValue = (header.dataType == 2) ? 2 : 4;
+    std::vector<char> row((x1 - x0) * bytesPerValue);
+    for (long y=y0; y<y1; y++)
+    {
+	std::uint64_t fileRow = header.nrows - 1 - y;
+	readFully(file, row.data(), row.size(), header.headerOffset + (fileRow * header.ncols + x0) * bytesPerValue, header.dataFileName);
+
+	for (long x=x0; x<x1; x++)
+	{
+	    char *bytes = &row[(x - x0) * bytesPerValue];
+	    if (header.swapBytes)
+	    {
+		std::reverse(bytes, bytes + bytesPerValue);
+	    }
+
+	    double value;
+	    if (bytesPerValue == 2)
+	    {
+		std::int16_t integer;
+		std::memcpy(&integer, bytes, sizeof(integer));
+		value = integer;
+	    }
+	    else
+	    {
+		float single;
+		std::memcpy(&single, bytes, sizeof(single));
+		value = single;
+	    }
+
+	    LibGeoDecomp::Coord<2> coordinate(x, y);
+	    Cell cell = localGrid->get(coordinate);
+	    cell.elevation = value;
+	    localGrid->set(coordinate, cell);
+	}
+    }
+}
+
+
+
+// Byte offsets of the start of every line of the file. Each rank
+// scans its share of the file for line ends, then all offsets are
+// gathered on all ranks.
+std::vector<std::uint64_t> RasterInitializer::indexLines(int file)
+{
+    struct stat status;
+    fstat(file, &status);
+    std::uint64_t fileSize = status.st_size;
+
+    int rank = LibGeoDecomp::MPILayer().rank();
+    int size = LibGeoDecomp::MPILayer().size();
+    std::uint64_t begin = fileSize * rank / size;
+    std::uint64_t end = fileSize * (rank + 1) / size;
+
+    std::vector<std::uint64_t> localStarts;
+    if (rank == 0)
+    {
+	localStarts.push_back(0);
+    }
+    std::vector<char> buffer(1 << 22);
+    for (std::uint64_t offset=begin; offset<end; offset+=buffer.size())
+    {
+	std::uint64_t bytes = std::min<std::uint64_t>(buffer.size(), end - offset);
+	readFully(file, buffer.data(), bytes, offset, header.dataFileName);
+	for (std::uint64_t i=0; i<bytes; i++)
+	{
+	    if (buffer[i] == '\n' && offset + i + 1 < fileSize)
+	    {
+		localStarts.push_back(offset + i + 1);
+	    }
+	}
+    }
+
+    int localCount = localStarts.size();
+    std::vector<int> counts(size);
+    MPI_Allgather(&localCount, 1, MPI_INT, counts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+    std::vector<int> displacements(size, 0);
+    for (int i=1; i<size; i++)
+    {
+	displacements[i] = displacements[i-1] + counts[i-1];
+    }
+
+    std::vector<std::uint64_t> starts(displacements[size-1] + counts[size-1]);
+    MPI_Allgatherv(localStarts.data(), localCount, MPI_UINT64_T,
+		   starts.data(), counts.data(), displacements.data(), MPI_UINT64_T, MPI_COMM_WORLD);
+    starts.push_back(fileSize); // end of the last line
+    return starts;
+}
+
+
+
+void RasterInitializer::readASCIIRows(LibGeoDecomp::GridBase<Cell, 2> *localGrid, int file)
+{
+    std::vector<std::uint64_t> lineStarts = indexLines(file);
+    if (lineStarts.size() < static_cast<size_t>(header.headerLines + header.nrows + 1))
+    {
+	rasterError("DEM " + header.dataFileName + " has fewer lines than rows, expecting one row per line");
+    }
+
+    LibGeoDecomp::CoordBox<2> box = localGrid->boundingBox();
+    long x0 = std::max(0, box.origin.x());
+    long x1 = std::min<long>(header.ncols, box.origin.x() + box.dimensions.x());
+    long y0 = std::max(0, box.origin.y());
+    long y1 = std::min<long>(header.nrows, box.origin.y() + box.dimensions.y());
+    if (x1 <= x0 || y1 <= y0)
+    {
+	return;
+    }
+
+    // The rows of this rank are contiguous in the file, read them at once
+    std::uint64_t firstLine = header.headerLines + (header.nrows - y1);
+    std::uint64_t lastLine = header.headerLines + (header.nrows - 1 - y0);
+    std::uint64_t blockStart = lineStarts[firstLine];
+    std::vector<char> block(lineStarts[lastLine + 1] - blockStart + 1);
+    readFully(file, block.data(), block.size() - 1, blockStart, header.dataFileName);
+    block.back() = '\0';
+
+    for (long y=y0; y<y1; y++)
+    {
+	std::uint64_t line = header.headerLines + (header.nrows - 1 - y);
+	char *position = &block[lineStarts[line] - blockStart];
+	char *lineEnd = &block[lineStarts[line + 1] - blockStart];
+
+	for (long x=0; x<x1; x++)
+	{
+	    char *next;
+	    double value = strtod(position, &next);
+	    if (next == position || next > lineEnd)
+	    {
+		std::cout << "Error reading DEM " << header.dataFileName << ": row " << header.nrows - 1 - y
+			  << " has fewer than " << x1 << " values" << std::endl;
+		exit(EXIT_FAILURE);
+	    }
+	    position = next;
+
+	    if (x >= x0)
+	    {
+		LibGeoDecomp::Coord<2> coordinate(x, y);
+		Cell cell = localGrid->get(coordinate);
+		cell.elevation = value;
+		localGrid->set(coordinate, cell);
+	    }
+	}
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef HC_RASTERINITIALIZER_H
+#define HC_RASTERINITIALIZER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <catchmentparameters.hpp>
+#include <localgridcache.hpp>
+#include <libgeodecomp/io/simpleinitializer.h>
+
+
+// Georeferencing and layout of a DEM in ESRI ASCII (.asc), ESRI float
+// (.flt + .hdr) or ENVI band interleaved (.bil + ENVI .hdr) format
+struct RasterHeader
+{
+    string format; // asc, flt or bil
+    string dataFileName;
+    long ncols = 0;
+    long nrows = 0;
+    double xllcorner = 0.0;
+    double yllcorner = 0.0;
+    double DX = 0.0;
+    double DY = 0.0;
+    double noDataValue = -9999.0;
+    int dataType = 4; // ENVI data type: 2 = 16 bit integer, 4 = 32 bit float
+    bool swapBytes = false; // byte order of file differs from this machine's
+    std::uint64_t headerOffset = 0; // bytes preceding the data in binary files
+    unsigned headerLines = 0; // lines preceding the data in ASCII files
+
+    static RasterHeader read(string fileName);
+};
+
+
+// Initialises the grid directly from a DEM raster, without
+// conversion to netCDF. Each rank reads only the rows of its own
+// subgrid: at their offsets (pread) for the binary formats, and for
+// ASCII through an index of line offsets built collectively by all
+// ranks, each scanning an equal share of the file.
+//
+// Raster rows are stored from north to south, so the first row of
+// the file is y = nrows-1 and the last row is y = 0 (north is +y).
+class RasterInitializer : public LibGeoDecomp::SimpleInitializer<Cell>
+{
+public:
+    // firstStep is the step the simulation starts from (when resuming
+    // after a dry period), running on to no_of_iterations
+    RasterInitializer(const CatchmentParameters& parameters,
+		      LocalGridCache *gridCache = 0,
+		      unsigned firstStep = 0);
+
+    void grid(LibGeoDecomp::GridBase<Cell, 2> *localGrid);
+
+    unsigned startStep() const
+    {
+	return firstStep;
+    }
+
+    const RasterHeader& getHeader() const
+    {
+	return header;
+    }
+
+private:
+    RasterInitializer(const CatchmentParameters& parameters,
+		      const RasterHeader& header,
+		      LocalGridCache *gridCache,
+		      unsigned firstStep);
+
+    void readBinaryRows(LibGeoDecomp::GridBase<Cell, 2> *localGrid, int file);
+    void readASCIIRows(LibGeoDecomp::GridBase<Cell, 2> *localGrid, int file);
+    std::vector<std::uint64_t> indexLines(int file);
+
+    CatchmentParameters parameters;
+    RasterHeader header;
+    LocalGridCache *gridCache;
+    unsigned firstStep;
+};
+
+
+
+#endif
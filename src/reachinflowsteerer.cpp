@@ -0,0 +1,101 @@
+#include <reachinflowsteerer.hpp>
+
+#include <climits>
+
+#include <libgeodecomp/communication/mpilayer.h>
+
+
+ReachInflowSteerer::ReachInflowSteerer(const CatchmentParameters& parameters) :
+    LibGeoDecomp::Steerer<Cell>(1),
+    parameters(parameters),
+    cellArea(parameters.DX * parameters.DY),
+    haveLocalCells(false),
+    cachedStep(UINT_MAX)
+{}
+
+
+
+// Inflow points within this rank's grid, grouped by cell
+void ReachInflowSteerer::findLocalCells(const GridType *grid, const CoordType& globalDimensions)
+{
+    LibGeoDecomp::CoordBox<2> localBox = grid->boundingBox();
+    for (unsigned point = 0; point < parameters.reachInflowX.size(); point++)
+    {
+	LibGeoDecomp::Coord<2> cell(parameters.reachInflowX[point], parameters.reachInflowY[point]);
+	if (cell.x() < 0 || cell.y() < 0 || cell.x() >= globalDimensions.x() || cell.y() >= globalDimensions.y())
+	{
+	    if (LibGeoDecomp::MPILayer().rank() == 0)
+	    {
+		std::cout << "Reach inflow point " << cell.x() << " " << cell.y() << " is outside the grid" << std::endl;
+	    }
+	    exit(EXIT_FAILURE);
+	}
+	if (!localBox.inBounds(cell))
+	{
+	    continue;
+	}
+
+	std::vector<InflowCell>::iterator inflowCell = localCells.begin();
+	while (inflowCell != localCells.end() && !(inflowCell->cell == cell))
+	{
+	    ++inflowCell;
+	}
+	if (inflowCell == localCells.end())
+	{
+	    localCells.push_back(InflowCell { cell, std::vector<unsigned>(), 0.0 });
+	    inflowCell = localCells.end() - 1;
+	}
+	inflowCell->points.push_back(point);
+    }
+    haveLocalCells = true;
+}
+
+
+
+void ReachInflowSteerer::nextStep(
+    GridType *grid,
+    const LibGeoDecomp::Region<2>& validRegion,
+    const CoordType& globalDimensions,
+    unsigned step,
+    LibGeoDecomp::SteererEvent event,
+    std::size_t rank,
+    bool lastCall,
+    LibGeoDecomp::SteererFeedback *feedback)
+{
+    if (event != LibGeoDecomp::STEERER_NEXT_STEP)
+    {
+	return;
+    }
+
+    if (!haveLocalCells)
+    {
+	findLocalCells(grid, globalDimensions);
+    }
+
+    // Interpolate the hydrographs once per step, however many calls
+    // the step is split into
+    if (step != cachedStep)
+    {
+	double time = step * parameters.timestep;
+	for (InflowCell& inflowCell : localCells)
+	{
+	    double discharge = 0.0;
+	    for (unsigned point : inflowCell.points)
+	    {
+		discharge += parameters.reachDischarge(point, time);
+	    }
+	    inflowCell.inflowRate = discharge * parameters.timestep / cellArea;
+	}
+	cachedStep = step;
+    }
+
+    for (const InflowCell& inflowCell : localCells)
+    {
+	if (validRegion.count(inflowCell.cell))
+	{
+	    Cell cell = grid->get(inflowCell.cell);
+	    cell.inflowRate = inflowCell.inflowRate;
+	    grid->set(inflowCell.cell, cell);
+	}
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef HC_REACHINFLOWSTEERER_H
+#define HC_REACHINFLOWSTEERER_H
+
+#include <vector>
+
+#include <cell.hpp>
+#include <catchmentparameters.hpp>
+
+#include <libgeodecomp/io/steerer.h>
+
+
+// Puts the discharge of the reach inflow points into their cells
+// (reach mode: water enters through the rivers crossing the domain, so
+// only the floodplain of interest needs to be simulated rather than
+// the whole catchment upstream of it).
+//
+// Only the rank owning the cell of a point injects its water. The
+// hydrographs are interpolated once per step for the local points
+// only, and the result is set as the inflowRate of their cells, which
+// add it in the next update.
+class ReachInflowSteerer : public LibGeoDecomp::Steerer<Cell>
+{
+public:
+    typedef LibGeoDecomp::Steerer<Cell>::GridType GridType;
+    typedef LibGeoDecomp::Steerer<Cell>::CoordType CoordType;
+
+    ReachInflowSteerer(const CatchmentParameters& parameters);
+
+    void nextStep(
+	GridType *grid,
+	const LibGeoDecomp::Region<2>& validRegion,
+	const CoordType& globalDimensions,
+	unsigned step,
+	LibGeoDecomp::SteererEvent event,
+	std::size_t rank,
+	bool lastCall,
+	LibGeoDecomp::SteererFeedback *feedback);
+
+private:
+    // A local cell with one or more inflow points
+    struct InflowCell
+    {
+	LibGeoDecomp::Coord<2> cell;
+	std::vector<unsigned> points;
+	double inflowRate; // m/timestep, at cachedStep
+    };
+
+    void findLocalCells(const GridType *grid, const CoordType& globalDimensions);
+
+    CatchmentParameters parameters;
+    double cellArea;
+    bool haveLocalCells;
+    std::vector<InflowCell> localCells;
+    unsigned cachedStep;
+};
+
+#endif
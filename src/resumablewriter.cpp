@@ -0,0 +1,46 @@
+#include <resumablewriter.hpp>
+
+
+ResumableWriter::ResumableWriter(LibGeoDecomp::ParallelWriter<Cell> *writer,
+				 bool resumed,
+				 unsigned driedOutStep,
+				 const bool *driedOut) :
+    LibGeoDecomp::ParallelWriter<Cell>("", writer->getPeriod()),
+    writer(writer),
+    resumed(resumed),
+    driedOutStep(driedOutStep),
+    driedOut(driedOut)
+{}
+
+
+
+void ResumableWriter::stepFinished(
+    const GridType& grid,
+    const LibGeoDecomp::Region<2>& validRegion,
+    const LibGeoDecomp::Coord<2>& globalDimensions,
+    unsigned step,
+    LibGeoDecomp::WriterEvent event,
+    std::size_t rank,
+    bool lastCall)
+{
+    if (event == LibGeoDecomp::WRITER_INITIALIZED && resumed)
+    {
+	// Output steps from the one the catchment dried out at (which
+	// the saved state is of) up to the step resumed from
+	unsigned period = getPeriod();
+	for (unsigned outputStep = (driedOutStep + period - 1) / period * period; outputStep <= step; outputStep += period)
+	{
+	    writer->stepFinished(grid, validRegion, globalDimensions, outputStep,
+				 LibGeoDecomp::WRITER_STEP_FINISHED, rank, lastCall);
+	}
+	return;
+    }
+
+    // The run goes on from the next step with rain
+    if (event == LibGeoDecomp::WRITER_ALL_DONE && *driedOut)
+    {
+	return;
+    }
+
+    writer->stepFinished(grid, validRegion, globalDimensions, step, event, rank, lastCall);
+}
@@ -0,0 +1,54 @@
+#ifndef HC_RESUMABLEWRITER_H
+#define HC_RESUMABLEWRITER_H
+
+#include <cell.hpp>
+
+#include <libgeodecomp/io/parallelwriter.h>
+
+
+// Passes the output of one LibGeoDecomp simulation on to a writer
+// that lives for the whole run, so that a run resumed after a dry
+// fast-forward writes on to the same files as one series of steps.
+//
+// LibGeoDecomp simulators own their writers, so each simulation of
+// the run gets one of these instead. The writer sees
+// WRITER_INITIALIZED only at the start of the run, and WRITER_ALL_DONE
+// only at its end: not when a simulation is ended because the
+// catchment dried out. On resuming, the output steps that were
+// fast-forwarded over are written from the saved dry state that the
+// resumed simulation starts from, as nothing changed in between.
+class ResumableWriter : public LibGeoDecomp::ParallelWriter<Cell>
+{
+public:
+    typedef LibGeoDecomp::ParallelWriter<Cell>::GridType GridType;
+
+    // The writer is not owned. driedOutStep is the step the previous
+    // simulation of the run ended at, if resumed; driedOut is set by
+    // the RainfallSteerer when this simulation ends with the catchment dry
+    ResumableWriter(LibGeoDecomp::ParallelWriter<Cell> *writer,
+		    bool resumed,
+		    unsigned driedOutStep,
+		    const bool *driedOut);
+
+    LibGeoDecomp::ParallelWriter<Cell> *clone() const
+    {
+	return new ResumableWriter(*this);
+    }
+
+    void stepFinished(
+	const GridType& grid,
+	const LibGeoDecomp::Region<2>& validRegion,
+	const LibGeoDecomp::Coord<2>& globalDimensions,
+	unsigned step,
+	LibGeoDecomp::WriterEvent event,
+	std::size_t rank,
+	bool lastCall);
+
+private:
+    LibGeoDecomp::ParallelWriter<Cell> *writer;
+    bool resumed;
+    unsigned driedOutStep;
+    const bool *driedOut;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef HC_ROOTINPUT_H
+#define HC_ROOTINPUT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <mpi.h>
+
+
+// Small startup inputs (parameter files, event lists, rain schedules,
+// raster headers) are read by rank 0 only and their contents broadcast
+// to all other ranks, which then parse them from memory exactly as rank
+// 0 does. At thousands of ranks this saves every rank opening the same
+// files on the shared file system.
+//
+// Reads at most maxBytes from the start of the file (enough for a
+// header at the start of a large file). Returns false on every rank if
+// rank 0 could not open the file.
+inline bool readOnRootAndBroadcast(const std::string& fileName, std::string& contents,
+				   std::uint64_t maxBytes = UINT64_MAX)
+{
+    const std::uint64_t unreadable = UINT64_MAX;
+    std::uint64_t size = unreadable;
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    if (rank == 0)
+    {
+	std::ifstream infile(fileName.c_str(), std::ios::in | std::ios::binary);
+	if (infile.good())
+	{
+	    std::vector<char> buffer(1 << 16);
+	    contents.clear();
+	    while (contents.size() < maxBytes && infile.read(buffer.data(), buffer.size()).gcount() > 0)
+	    {
+		contents.append(buffer.data(), infile.gcount());
+	    }
+	    if (contents.size() > maxBytes)
+	    {
+		contents.resize(maxBytes);
+	    }
+	    size = contents.size();
+	}
+    }
+
+    MPI_Bcast(&size, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+    if (size == unreadable)
+    {
+	contents.clear();
+	return false;
+    }
+
+    contents.resize(size);
+    const std::uint64_t maxMessage = 1 << 30;
+    for (std::uint64_t offset = 0; offset < size; offset += maxMessage)
+    {
+	int count = static_cast<int>(std::min(maxMessage, size - offset));
+	MPI_Bcast(&contents[offset], count, MPI_CHAR, 0, MPI_COMM_WORLD);
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef HC_SEDIMENT_H
+#define HC_SEDIMENT_H
+
+
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// SEDIMENT TRANSPORT: bedload erosion and deposition
+//
+// Ported from LSDCatchmentModel::erode, split over two nanosteps:
+// erode() works out how much of each grain size class leaves a cell
+// and in which directions, deposit() then moves it into the
+// neighbours. Only the bedload is ported (no suspended sediment,
+// lateral erosion, bedrock or vegetation), and the active layer is
+// replenished with the initial bed composition instead of from
+// strata.
+//
+// Instead of repeating the erosion of the whole grid with a smaller
+// global timestep whenever a cell exceeds the erosion limit, each
+// cell scales its own transport down to the limit, which is the same
+// as giving it a shorter local erosion timestep.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+template<typename COORD_MAP>
+void Cell::erode(const COORD_MAP& neighborhood)
+{
+    for (int n = 0; n < grainClasses; n++)
+    {
+	entrained[n] = 0.0;
+    }
+    for (int p = 0; p < 4; p++)
+    {
+	sedimentShare[p] = 0.0;
+    }
+
+    // Edge cells take in whatever reaches them, which so leaves the
+    // catchment, and move nothing themselves
+    if (celltype != INTERNAL || here.waterDepth <= waterDepthErosionThreshold)
+    {
+	return;
+    }
+
+    // Velocities out of the cell, from the discharges of the previous
+    // nanostep (the discharges of the east and north faces belong to
+    // the east and north neighbours)
+    double velocity[4] = {};
+    double neighbour_elevation[4] = { east.elevation, north.elevation, west.elevation, south.elevation };
+    double neighbour_waterDepth[4] = { east.waterDepth, north.waterDepth, west.waterDepth, south.waterDepth };
+    double distance[4] = { DX, DY, DX, DY };
+    if (east.qX < 0 && east.hflowX > 0) velocity[EAST] = -east.qX / east.hflowX;
+    if (north.qY < 0 && north.hflowY > 0) velocity[NORTH] = -north.qY / north.hflowY;
+    if (here.qX > 0 && here.hflowX > 0) velocity[WEST] = here.qX / here.hflowX;
+    if (here.qY > 0 && here.hflowY > 0) velocity[SOUTH] = here.qY / here.hflowY;
+
+    double velocitySquared[4] = {};
+    double velocityTotal = 0.0;
+    double slopeTotal = 0.0;
+    for (int p = 0; p < 4; p++)
+    {
+	if (neighbour_waterDepth[p] > waterDepthErosionThreshold && velocity[p] > 0)
+	{
+	    double vel = std::min(velocity[p], maxTauVelocity);
+	    velocitySquared[p] = vel * vel;
+	    velocityTotal += velocitySquared[p];
+	    slopeTotal += ((here.elevation - neighbour_elevation[p]) / distance[p]) * vel;
+	}
+    }
+    if (velocityTotal <= 0)
+    {
+	return;
+    }
+
+    // Bed shear stress
+    double vel = std::min(std::sqrt(velocityTotal), maxTauVelocity);
+    double ci = gravity * (mannings * mannings) * std::pow(here.waterDepth, -0.33);
+    slopeTotal = std::min(slopeTotal, 0.0);
+    double tau = 1000 * ci * vel * vel * (1 + (slopeTotal / vel));
+    if (tau <= 0)
+    {
+	return;
+    }
+
+    double d_50 = 0.0;
+    double Fs = 0.0;
+    double grainTotal = 0.0;
+    if (wilcock)
+    {
+	d_50 = std::max(d50(), grainSize[0]);
+	Fs = sandFraction();
+	for (int n = 0; n < grainClasses; n++)
+	{
+	    grainTotal += here.grain[n];
+	}
+    }
+
+    double total = 0.0;
+    for (int n = 0; n < grainClasses; n++)
+    {
+	// no more than there is in the active layer
+	entrained[n] = std::max(std::min(transportCapacity(n, tau, d_50, Fs, grainTotal), here.grain[n]), 0.0);
+	total += entrained[n];
+    }
+
+    if (total > erosionLimit)
+    {
+	double scale = erosionLimit / total;
+	for (int n = 0; n < grainClasses; n++)
+	{
+	    entrained[n] *= scale;
+	}
+    }
+
+    for (int p = 0; p < 4; p++)
+    {
+	sedimentShare[p] = velocitySquared[p] / velocityTotal;
+    }
+}
+
+
+// Volume (m per unit area) of grain size class n the flow can move
+// in one timestep
+double Cell::transportCapacity(int n, double tau, double d_50, double Fs, double grainTotal) const
+{
+    const double rho = 1000.0;
+    double Di = grainSize[n];
+
+    if (wilcock)
+    {
+	// Wilcock and Crowe/Curran
+	if (grainTotal <= 0)
+	{
+	    return 0.0;
+	}
+	double tau_ri = (0.021 + (0.015 * std::exp(-20 * Fs))) * (rho * gravity * d_50)
+	    * std::pow((Di / d_50), (0.67 / (1 + std::exp(1.5 - (Di / d_50)))));
+	double U_star = std::sqrt(tau / rho);
+	double Fi = grain[n] / grainTotal;
+	double Wi_star;
+	if ((tau / tau_ri) < 1.35)
+	{
+	    Wi_star = 0.002 * std::pow(tau / tau_ri, 7.5);
+	}
+	else
+	{
+	    Wi_star = 14 * std::pow(1 - (0.894 / std::sqrt(tau / tau_ri)), 4.5);
+	}
+	return timestep * ((Fi * (U_star * U_star * U_star)) / ((2.65 - 1) * gravity)) * Wi_star / DX;
+    }
+
+    // Einstein
+    return timestep * (40 * std::pow((1 / (((2650 - 1000) * Di) / (tau / gravity))), 3))
+	/ std::sqrt(1000 / ((2250 - 1000) * gravity * (Di * Di * Di))) / DX;
+}
+
+
+template<typename COORD_MAP>
+void Cell::deposit(const COORD_MAP& neighborhood)
+{
+    if (celltype != INTERNAL)
+    {
+	return;
+    }
+
+    double outShare = here.sedimentShare[EAST] + here.sedimentShare[NORTH]
+	+ here.sedimentShare[WEST] + here.sedimentShare[SOUTH];
+    double change = 0.0;
+    for (int n = 0; n < grainClasses; n++)
+    {
+	double in = west.entrained[n] * west.sedimentShare[EAST]
+	    + south.entrained[n] * south.sedimentShare[NORTH]
+	    + east.entrained[n] * east.sedimentShare[WEST]
+	    + north.entrained[n] * north.sedimentShare[SOUTH];
+	double out = here.entrained[n] * outShare;
+	grain[n] = here.grain[n] + in - out;
+	change += in - out;
+    }
+
+    if (change != 0.0)
+    {
+	elevation = here.elevation + change;
+	if (waterDepth > 0)
+	{
+	    waterLevel = elevation + waterDepth;
+	}
+	if (change < 0)
+	{
+	    replenishActiveLayer();
+	}
+    }
+}
+
+
+// Tops the active layer up to its thickness from the bed below,
+// assumed to be of the initial composition
+void Cell::replenishActiveLayer()
+{
+    double thickness = 0.0;
+    for (int n = 0; n < grainClasses; n++)
+    {
+	thickness += grain[n];
+    }
+    if (thickness < activeLayerThickness)
+    {
+	for (int n = 0; n < grainClasses; n++)
+	{
+	    grain[n] += (activeLayerThickness - thickness) * grainProportion[n];
+	}
+    }
+}
+
+
+// Median grain size of the active layer (m), interpolated
+// logarithmically between the class sizes
+double Cell::d50() const
+{
+    double cumulative[grainClasses + 1] = {};
+    for (int n = 0; n < grainClasses; n++)
+    {
+	cumulative[n + 1] = cumulative[n] + grain[n];
+    }
+    double thickness = cumulative[grainClasses];
+    if (thickness < 0.0000001)
+    {
+	return 0.0;
+    }
+
+    int i = 1;
+    while (cumulative[i] < thickness * 0.5 && i < grainClasses)
+    {
+	i++;
+    }
+    double max = std::log(grainSize[i - 1]);
+    double min = std::log(grainSize[std::max(i - 2, 0)]);
+    if (cumulative[i] <= cumulative[i - 1])
+    {
+	return std::exp(max);
+    }
+    return std::exp(max - ((max - min) * ((cumulative[i] - (thickness * 0.5)) / (cumulative[i] - cumulative[i - 1]))));
+}
+
+
+// Proportion of sand (the two finest classes) in the active layer
+double Cell::sandFraction() const
+{
+    double thickness = 0.0;
+    for (int n = 0; n < grainClasses; n++)
+    {
+	thickness += grain[n];
+    }
+    if (thickness < 0.0001)
+    {
+	return 0.0;
+    }
+    return (grain[0] + grain[1]) / thickness;
+}
+
+
+#endif
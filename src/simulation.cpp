@@ -3,7 +3,10 @@
 #include <libgeodecomp/parallelization/stripingsimulator.h>
 
 Simulation::Simulation(string parameterFile) :
-    parameters(CatchmentParameters(parameterFile))
+    parameters(CatchmentParameters(parameterFile)),
+    initializer(0),
+    serialSimulator(0),
+    parallelSimulator(0)
 {}
 
 
@@ -21,12 +24,26 @@ void Simulation::gatherNetCDFSources()
 
 
 
-void Simulation::prepareInitializer()
+void Simulation::prepareInitializer(LocalGridCache *initialState)
 {
-    gatherNetCDFSources();
-
     // Initialise grid (each rank initialises its own subgrid)
-    initializer = new NetCDFInitializer(parameters, netCDFSources);
+    if (!parameters.inputRasterFileName.empty())
+    {
+	RasterInitializer *rasterInitializer = new RasterInitializer(parameters, initialState ? initialState : &gridCache, firstStep);
+
+	// Cell size as given by the DEM header
+	parameters.DX = rasterInitializer->getHeader().DX;
+	parameters.DY = rasterInitializer->getHeader().DY;
+	initializer = rasterInitializer;
+	return;
+    }
+    
+    if (netCDFSources.empty())
+    {
+	gatherNetCDFSources();
+    }
+
+    initializer = new NetCDFInitializer(parameters, netCDFSources, initialState ? initialState : &gridCache, firstStep);
 }
 
 
@@ -34,6 +51,10 @@ void Simulation::prepareSimulator()
 {
     LibGeoDecomp::LoadBalancer *balancer;
 
+    // Halo exchanges only carry the sediment fluxes if erosion is on;
+    // the simulator takes the datatype when it is created
+    MPI_CELL = parameters.hydro_model_only ? MPI_CELL_HYDROLOGY : MPI_CELL_SEDIMENT;
+
     if(parameters.simulator == "serial")
     {
 	serialSimulator = new LibGeoDecomp::SerialSimulator<Cell>(initializer);
@@ -68,22 +89,92 @@ void Simulation::addWriters()
     }
     else
     {
-	for (GridQuantity quantity : parameters.outputNetCDFGridQuantities)
+	// Made by the first simulation of the run
+	if (writers.empty())
+	{
+	    for (GridQuantity quantity : parameters.outputNetCDFGridQuantities)
+	    {
+		writers.push_back(new LibGeoDecomp::PnetCDFWriter<Cell>(
+				      initializer->gridDimensions(),
+				      gridQuantitySelectors[static_cast<int>(quantity)],
+				      outputPrefix + gridQuantityString[static_cast<int>(quantity)],
+				      parameters.outputNetCDFInterval[static_cast<int>(quantity)],
+				      parameters.no_of_iterations));
+	    }
+
+	    if (!parameters.performance_report_file.empty() && parameters.performance_snapshot_interval > 0)
+	    {
+		writers.push_back(new PerformanceWriter(
+				      outputPrefix + parameters.performance_report_file + "_snapshots.csv",
+				      parameters.performance_snapshot_interval));
+	    }
+
+	    if (LibGeoDecomp::MPILayer().rank() == 0)
+	    {
+		LibGeoDecomp::TracingWriter<Cell> *progressWriter = new LibGeoDecomp::TracingWriter<Cell>(parameters.progress_interval, parameters.no_of_iterations);
+		writers.push_back(progressWriter);
+	    }
+	}
+
+	for (LibGeoDecomp::ParallelWriter<Cell> *writer : writers)
 	{
-	    pnetCDFWriters.push_back(new LibGeoDecomp::PnetCDFWriter<Cell>(
-					 initializer->gridDimensions(),
-					 gridQuantitySelectors[static_cast<int>(quantity)],
-					 gridQuantityString[static_cast<int>(quantity)],
-					 parameters.outputNetCDFInterval[static_cast<int>(quantity)],
-					 parameters.no_of_iterations));
-	    
-	    parallelSimulator->addWriter(pnetCDFWriters[static_cast<int>(quantity)]); 
+	    parallelSimulator->addWriter(new ResumableWriter(writer, firstStep > 0, driedOutStep, &driedOut));
 	}
+    }
+}
+
+
+
+void Simulation::addSteerers()
+{
+    vector<LibGeoDecomp::Steerer<Cell>*> steerers;
+
+    // Made first, as the ConvergenceSteerer needs to know when the
+    // gridded rainfall ends
+    RainfallSteerer *rainfallSteerer = 0;
+    driedOut = false;
+    if (!parameters.rainScheduleStep.empty() || parameters.fast_forward_dry_periods
+	|| !parameters.inputRainNetCDFFileName.empty())
+    {
+	rainfallSteerer = new RainfallSteerer(parameters, &stateCache, &driedOut, &driedOutStep);
+    }
+    
+    if (parameters.convergence_check_interval > 0)
+    {
+	steerers.push_back(new ConvergenceSteerer(parameters,
+						  rainfallSteerer ? rainfallSteerer->rainEndStep() : 0));
+    }
+
+    if ((!parameters.inputRainNetCDFFileName.empty() || parameters.topmodel_runoff || !parameters.reachInflowX.empty())
+	&& parameters.fast_forward_dry_periods && LibGeoDecomp::MPILayer().rank() == 0)
+    {
+	std::cout << "Fast-forward through dry periods is not supported with gridded rainfall, TOPMODEL runoff or reach inflows, ignoring it" << std::endl;
+    }
+    if (rainfallSteerer)
+    {
+	steerers.push_back(rainfallSteerer);
+    }
+
+    // After the RainfallSteerer, so that zone rainfall includes its changes
+    if (parameters.topmodel_runoff && !parameters.inputNetCDFFileName[GridQuantity::hydroIndex].empty())
+    {
+	steerers.push_back(new TopmodelSteerer(parameters));
+    }
+
+    if (!parameters.reachInflowX.empty())
+    {
+	steerers.push_back(new ReachInflowSteerer(parameters));
+    }
 
-	if (LibGeoDecomp::MPILayer().rank() == 0)
+    for (LibGeoDecomp::Steerer<Cell> *steerer : steerers)
+    {
+	if (parameters.simulator == "serial")
+	{
+	    serialSimulator->addSteerer(steerer);
+	}
+	else
 	{
-	    LibGeoDecomp::TracingWriter<Cell> *progressWriter = new LibGeoDecomp::TracingWriter<Cell>(parameters.progress_interval, parameters.no_of_iterations);
-	    parallelSimulator->addWriter(progressWriter);
+	    parallelSimulator->addSteerer(steerer);
 	}
     }
 }
@@ -97,6 +188,8 @@ void Simulation::run()
 	std::cout << "\nStarting simulation... \n";
     }
 
+    double startTime = MPI_Wtime();
+    
     if (parameters.simulator == "serial")
     {
 	serialSimulator->run();
@@ -110,9 +203,162 @@ void Simulation::run()
 	    std::cout << std::endl;
 	}
     }
-    
 
-    
+    if (!parameters.performance_report_file.empty())
+    {
+	// Per-rank timings kept by LibGeoDecomp (gathering is collective)
+	wallTime += MPI_Wtime() - startTime;
+	std::vector<LibGeoDecomp::Chronometer> simulationStatistics;
+	if (parameters.simulator == "serial")
+	{
+	    simulatedSteps += serialSimulator->getStep() - firstStep;
+	    simulationStatistics = serialSimulator->gatherStatistics();
+	}
+	else
+	{
+	    simulatedSteps += parallelSimulator->getStep() - firstStep;
+	    simulationStatistics = parallelSimulator->gatherStatistics();
+	}
+
+	LibGeoDecomp::Coord<2> dimensions = initializer->gridDimensions();
+	cells = static_cast<double>(dimensions.x()) * dimensions.y();
+	if (statistics.empty())
+	{
+	    statistics = simulationStatistics;
+	}
+	else
+	{
+	    for (std::size_t rank = 0; rank < simulationStatistics.size(); rank++)
+	    {
+		statistics[rank] += simulationStatistics[rank];
+	    }
+	}
+    }
+}
+
+
+
+// Of the steps actually simulated, leaving out the dry periods
+// fast-forwarded through
+void Simulation::writePerformanceSummary()
+{
+    if (!parameters.performance_report_file.empty())
+    {
+	PerformanceWriter::writeSummary(outputPrefix + parameters.performance_report_file,
+					statistics,
+					wallTime,
+					cells,
+					simulatedSteps);
+    }
+
+    statistics.clear();
+    wallTime = 0.0;
+    simulatedSteps = 0;
+}
+
+
+
+void Simulation::runSimulation()
+{
+    CatchmentParameters runParameters = parameters;
+    LocalGridCache *initialState = &gridCache;
+    firstStep = 0;
+    parameters.physicalRainRate = runParameters.rainRateAtStep(0);
+
+    while (true)
+    {
+	prepareInitializer(initialState);
+	prepareSimulator();
+	addWriters();
+	addSteerers();
+
+	LibGeoDecomp::MPILayer().barrier();
+
+	run();
+	deleteSimulator();
+
+	if (!driedOut)
+	{
+	    break;
+	}
+
+	// Nothing happens until it rains again, so resume from the
+	// saved dry state at the next step with rain. Without more rain
+	// the run still resumes, at its last step, so that the writers
+	// fill in the dry outputs up to there and finish
+	firstStep = std::min(runParameters.nextRainStep(driedOutStep), runParameters.no_of_iterations);
+	if(LibGeoDecomp::MPILayer().rank() == 0)
+	{
+	    std::cout << "Catchment dry at step " << driedOutStep
+		      << ", fast-forwarding to step " << firstStep << std::endl;
+	}
+
+	parameters = runParameters;
+	parameters.physicalRainRate = runParameters.rainRateAtStep(firstStep);
+	parameters.inundate_below_elevation = false;
+	parameters.inundate_above_elevation = false;
+	initialState = &stateCache;
+    }
+
+    writePerformanceSummary();
+
+    for (LibGeoDecomp::ParallelWriter<Cell> *writer : writers)
+    {
+	delete writer;
+    }
+    writers.clear();
+
+    parameters = runParameters;
+    firstStep = 0;
+    stateCache.cells.clear();
+}
+
+
+
+void Simulation::runEvents()
+{
+    // Parameters of the catchment itself, which each event overrides
+    CatchmentParameters catchmentParameters = parameters;
+
+    for (string eventParameterFile : catchmentParameters.eventParameterFiles)
+    {
+	parameters = catchmentParameters;
+	parameters.eventParameterFiles.clear();
+	parameters.readParameters(eventParameterFile);
+
+	// Per-event outputs are named after the event parameter file
+	string eventName = eventParameterFile.substr(eventParameterFile.find_last_of('/') + 1);
+	eventName = eventName.substr(0, eventName.find_last_of('.'));
+	outputPrefix = eventName + "_";
+
+	if(LibGeoDecomp::MPILayer().rank() == 0)
+	{
+	    std::cout << "\n=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-" << std::endl;
+	    std::cout << " Event: " << eventName << std::endl;
+	    std::cout << "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-" << std::endl;
+	}
+
+	// The grid cache is filled on the first event, so the
+	// netCDF input is only read once for the whole batch
+	runSimulation();
+    }
+
+    parameters = catchmentParameters;
+    outputPrefix = "";
+}
+
+
+
+// LibGeoDecomp simulators take ownership of their initializer,
+// writers and steerers, so deleting the simulator releases those as
+// well (but not the writers of the run they pass their output on to)
+void Simulation::deleteSimulator()
+{
+    delete serialSimulator;
+    delete parallelSimulator;
+    serialSimulator = 0;
+    parallelSimulator = 0;
+    initializer = 0;
 }
 
 
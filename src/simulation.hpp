@@ -9,6 +9,13 @@
 #include <cell.hpp>
 #include <catchmentparameters.hpp>
 #include <netcdfinitializer.hpp>
+#include <rasterinitializer.hpp>
+#include <convergencesteerer.hpp>
+#include <rainfallsteerer.hpp>
+#include <topmodelsteerer.hpp>
+#include <reachinflowsteerer.hpp>
+#include <performancewriter.hpp>
+#include <resumablewriter.hpp>
 //#include <selectmpidatatype.tpp>
 
 #include <libgeodecomp/communication/mpilayer.h>
@@ -29,26 +36,56 @@
 class Simulation
 {
 public:
-    // Read parameters on each rank
-    // (can replace with MPI_Bcast from rank 0 if overhead ever becomes noticeable)
+    // Parameters are read by rank 0 and broadcast to all ranks (see rootinput.hpp)
     Simulation(string parameterFile);
 
     void gatherNetCDFSources();
     
-    void prepareInitializer();
+    void prepareInitializer(LocalGridCache *initialState = 0);
     
     void prepareSimulator();
     
     void addWriters();
+
+    void addSteerers();
     
     void run();
+
+    // Runs the whole simulation, split into several LibGeoDecomp
+    // simulations when fast-forwarding through dry periods. Each
+    // resumed simulation carries on the step count of the run, and
+    // writes on to the outputs of the run
+    void runSimulation();
+
+    void writePerformanceSummary();
+
+    // Batch mode: run every event listed in the event list file
+    // against the catchment loaded once on the first event
+    void runEvents();
+
+    void deleteSimulator();
     
     CatchmentParameters parameters;
     vector<LibGeoDecomp::netCDFSource<Cell>> netCDFSources;
     LibGeoDecomp::Initializer<Cell> *initializer;
     LibGeoDecomp::SerialSimulator<Cell> *serialSimulator;
     LibGeoDecomp::DistributedSimulator<Cell> *parallelSimulator;
-    vector<LibGeoDecomp::PnetCDFWriter<Cell>*> pnetCDFWriters;
+    // Of the whole run, passed the output of each of its simulations
+    vector<LibGeoDecomp::ParallelWriter<Cell>*> writers;
+    LocalGridCache gridCache;
+    LocalGridCache stateCache;
+    string outputPrefix;
+
+    // Set by the RainfallSteerer when the catchment has dried out
+    unsigned firstStep = 0;
+    bool driedOut = false;
+    unsigned driedOutStep = 0;
+
+    // Accumulated over the simulations of the run
+    std::vector<LibGeoDecomp::Chronometer> statistics;
+    double wallTime = 0.0;
+    unsigned simulatedSteps = 0;
+    double cells = 0.0;
 };
 
 
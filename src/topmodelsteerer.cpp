@@ -0,0 +1,84 @@
+#include <topmodelsteerer.hpp>
+
+#include <libgeodecomp/communication/mpilayer.h>
+
+
+TopmodelSteerer::TopmodelSteerer(const CatchmentParameters& parameters) :
+    LibGeoDecomp::Steerer<Cell>(1),
+    timestep(parameters.timestep)
+{}
+
+
+
+void TopmodelSteerer::nextStep(
+    GridType *grid,
+    const LibGeoDecomp::Region<2>& validRegion,
+    const CoordType& globalDimensions,
+    unsigned step,
+    LibGeoDecomp::SteererEvent event,
+    std::size_t rank,
+    bool lastCall,
+    LibGeoDecomp::SteererFeedback *feedback)
+{
+    if (event != LibGeoDecomp::STEERER_NEXT_STEP)
+    {
+	return;
+    }
+
+    // Accumulate local contributions from this part of the grid
+    for (LibGeoDecomp::Region<2>::Iterator i = validRegion.begin(); i != validRegion.end(); ++i)
+    {
+	Cell cell = grid->get(*i);
+	unsigned zone = static_cast<unsigned>(cell.hydroIndex);
+	if (zone == 0)
+	{
+	    continue;
+	}
+	if (zone >= zoneRain.size())
+	{
+	    zoneRain.resize(zone + 1, 0.0);
+	    zoneCells.resize(zone + 1, 0.0);
+	}
+	zoneRain[zone] += cell.rainfall();
+	zoneCells[zone] += 1.0;
+    }
+
+    if (!lastCall)
+    {
+	return;
+    }
+
+    if (zoneJ.empty())
+    {
+	// Zones never change, so their number is only reduced once
+	unsigned localZones = zoneRain.size();
+	unsigned zones;
+	MPI_Allreduce(&localZones, &zones, 1, MPI_UNSIGNED, MPI_MAX, MPI_COMM_WORLD);
+	zoneJ.assign(zones, 0.000000001);
+	Cell::zoneRunoff.assign(zones, 0.0);
+    }
+    unsigned zones = zoneJ.size();
+    if (zones == 0)
+    {
+	return;
+    }
+    
+    // Rainfall sums followed by cell counts, in one reduction
+    std::vector<double> local(2 * zones, 0.0);
+    std::copy(zoneRain.begin(), zoneRain.end(), local.begin());
+    std::copy(zoneCells.begin(), zoneCells.end(), local.begin() + zones);
+    std::vector<double> total(2 * zones);
+    MPI_Allreduce(local.data(), total.data(), 2 * zones, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    zoneRain.assign(zones, 0.0);
+    zoneCells.assign(zones, 0.0);
+
+    for (unsigned zone = 1; zone < zones; zone++)
+    {
+	double cells = total[zones + zone];
+	if (cells > 0)
+	{
+	    double rain = total[zone] / cells / timestep;
+	    Cell::zoneRunoff[zone] = Cell::topmodelRunoff(rain, zoneJ[zone], timestep) * timestep;
+	}
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef HC_TOPMODELSTEERER_H
+#define HC_TOPMODELSTEERER_H
+
+#include <vector>
+
+#include <cell.hpp>
+#include <catchmentparameters.hpp>
+
+#include <libgeodecomp/io/steerer.h>
+
+
+// TOPMODEL runoff of the hydrological zones (cells with hydroIndex
+// 1, 2...), semi-distributed as in LSDCatchmentModel: all cells of a
+// zone share one subsurface store, driven by the mean rainfall over
+// the zone.
+//
+// Every step the rainfall and cell counts of each zone are summed
+// over the local cells and reduced across ranks in a single
+// MPI_Allreduce. Every rank then updates the same zone stores and
+// sets Cell::zoneRunoff, which the cells add in the next step. Every
+// cell of a zone gets its runoff, rather than only the catchment input
+// points as in LSDCatchmentModel (see Cell::topmodelWaterInputs).
+class TopmodelSteerer : public LibGeoDecomp::Steerer<Cell>
+{
+public:
+    typedef LibGeoDecomp::Steerer<Cell>::GridType GridType;
+    typedef LibGeoDecomp::Steerer<Cell>::CoordType CoordType;
+
+    TopmodelSteerer(const CatchmentParameters& parameters);
+
+    void nextStep(
+	GridType *grid,
+	const LibGeoDecomp::Region<2>& validRegion,
+	const CoordType& globalDimensions,
+	unsigned step,
+	LibGeoDecomp::SteererEvent event,
+	std::size_t rank,
+	bool lastCall,
+	LibGeoDecomp::SteererFeedback *feedback);
+
+private:
+    double timestep;
+
+    // Subsurface flow of each zone (m/s), empty until the number of
+    // zones has been reduced across ranks
+    std::vector<double> zoneJ;
+
+    // Local rainfall (m/timestep) and cell counts of each zone,
+    // accumulated over calls within one step
+    std::vector<double> zoneRain;
+    std::vector<double> zoneCells;
+};
+
+#endif
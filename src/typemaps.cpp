@@ -3,6 +3,8 @@
 #include <stdexcept>
 
 MPI_Datatype MPI_CELL;
+MPI_Datatype MPI_CELL_HYDROLOGY;
+MPI_Datatype MPI_CELL_SEDIMENT;
 
 
 // Member Specification, holds all relevant information for a given member.
@@ -25,13 +27,15 @@ bool addressLower(MemberSpec a, MemberSpec b)
     return a.address < b.address;
 }
 
+// The sediment members are only exchanged when erosion is on (added
+// by hand, keep when regenerating)
 MPI_Datatype
-Typemaps::generateMapCell() {
+Typemaps::generateMapCell(bool sediment) {
     char fakeObject[sizeof(Cell)];
     Cell *obj = (Cell*)fakeObject;
 
-    const int count = 17;
-    int lengths[count];
+    const int count = sediment ? 19 : 17;
+    int lengths[19];
 
     // sort addresses in ascending order
     MemberSpec rawSpecs[] = {
@@ -51,13 +55,15 @@ Typemaps::generateMapCell() {
         MemberSpec(getAddress(&obj->qY), lookup<double >(), 1),
         MemberSpec(getAddress(&obj->timestep), lookup<double >(), 1),
         MemberSpec(getAddress(&obj->waterDepth), lookup<double >(), 1),
-        MemberSpec(getAddress(&obj->waterLevel), lookup<double >(), 1)
+        MemberSpec(getAddress(&obj->waterLevel), lookup<double >(), 1),
+        MemberSpec(getAddress(&obj->entrained), lookup<double >(), Cell::grainClasses),
+        MemberSpec(getAddress(&obj->sedimentShare), lookup<double >(), 4)
     };
     std::sort(rawSpecs, rawSpecs + count, addressLower);
 
     // split addresses from member types
-    MPI_Aint displacements[count];
-    MPI_Datatype memberTypes[count];
+    MPI_Aint displacements[19];
+    MPI_Datatype memberTypes[19];
     for (int i = 0; i < count; i++) {
         displacements[i] = rawSpecs[i].address;
         memberTypes[i] = rawSpecs[i].type;
@@ -95,7 +101,9 @@ void Typemaps::initializeMaps()
         throw std::logic_error("MPI needs to be initialized prior to setting up Typemaps");
     }
 
-    MPI_CELL = generateMapCell();
+    MPI_CELL_HYDROLOGY = generateMapCell(false);
+    MPI_CELL_SEDIMENT = generateMapCell(true);
+    MPI_CELL = MPI_CELL_HYDROLOGY;
 
     mapsCreated = true;
 }
@@ -6,6 +6,8 @@
 #include <cell.hpp>
 
 extern MPI_Datatype MPI_CELL;
+extern MPI_Datatype MPI_CELL_HYDROLOGY; // Cell without the sediment members
+extern MPI_Datatype MPI_CELL_SEDIMENT;
 
 /**
  * Utility class which can set up and yield MPI datatypes for custom datatypes.
@@ -61,7 +63,7 @@ private:
 
     static bool mapsCreated;
 
-    static MPI_Datatype generateMapCell();
+    static MPI_Datatype generateMapCell(bool sediment);
 
 public:
     static inline MPI_Datatype lookup(bool*)
@@ -1,7 +1,12 @@
 #ifndef HC_UPDATE_H
 #define HC_UPDATE_H
 
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
 #include <hydrology.tpp>
+#include <sediment.tpp>
 
 // Overall update routine - this is what LibGeoDecomp calls each time
 // step for each cell
@@ -47,6 +52,10 @@
 
 
 
+// update() copies the hydrology part of a Cell bytewise
+static_assert(std::is_trivially_copyable<Cell>::value && std::is_standard_layout<Cell>::value,
+	      "Cell must stay a plain struct");
+
 template<typename COORD_MAP>
 void Cell::update(const COORD_MAP& neighborhood, unsigned nanoStep)
 {
@@ -62,9 +71,8 @@ void Cell::update(const COORD_MAP& neighborhood, unsigned nanoStep)
 	   set_inputoutput_diff();
 	   set_maximum_timestep();
 	   
-	   // Hydrological and flow routing processes
-	   // In reach mode, add the reach inputs and hydrology
-	   simulation.reach_water_and_sediment_input();
+	   // (reach water inputs are added by catchmentWaterInputs,
+	   // sediment inputs are still to come)
     */
     
     // Quantities that will need to be computed across grid
@@ -80,7 +88,16 @@ void Cell::update(const COORD_MAP& neighborhood, unsigned nanoStep)
 
     // Need to ensure that all grid variables (not just those that are
     // modified) are retained from one nanoStep to the next, so point:
-    *this = here;
+    // (without erosion the sediment state, declared last, is never
+    // read, so only the members in front of it are copied)
+    if(erosion)
+    {
+	*this = here;
+    }
+    else
+    {
+	std::memcpy(this, &here, offsetof(Cell, grain));
+    }
     
     if(nanoStep == 0)
     {
@@ -102,11 +119,25 @@ void Cell::update(const COORD_MAP& neighborhood, unsigned nanoStep)
     if(nanoStep == 2)
     {
 	depthUpdate(neighborhood);
+
+	// Bedload leaving each cell, from the flow routed in the
+	// previous nanostep
+	if(erosion)
+	{
+	    erode(neighborhood);
+	}
     }
     if(nanoStep == 3)
     {
 	// Water outputs from edges/catchment outlet 
 	waterFluxOut(neighborhood);
+
+	// Bedload arriving from the neighbours: travels with the halo
+	// exchange after the previous nanostep, so needs none of its own
+	if(erosion)
+	{
+	    deposit(neighborhood);
+	}
     }
 }
 
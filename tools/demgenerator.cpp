@@ -0,0 +1,166 @@
+// Synthetic DEM generator for scaling benchmarks.
+//
+// Generates a catchment of arbitrary size and writes it as a parallel
+// netCDF file that can be used directly as input_dem_netcdf_file
+// (variable Band1, dimensions y and x, as in test/idealised).
+//
+// The large scale relief is a pseudo-fractal surface produced on rank
+// 0 by LSDRaster::DiamondSquare on a grid of at most 1024 x 1024
+// nodes, broadcast to all ranks. Each rank then computes only its own
+// block of rows of the full size DEM, by bilinear interpolation of that
+// surface plus a regional tilt towards the southern edge (so that the
+// catchment drains) and small scale roughness, and all ranks write
+// their rows collectively. Nothing of full size is ever held by a
+// single rank, so DEMs of 64k x 64k cells and more can be generated.
+//
+// Usage: mpirun -np <ranks> bin/demgen <nx> <ny> <output.nc> [relief (m)] [tilt (m)]
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <mpi.h>
+#include <pnetcdf.h>
+
+#include <LSDRaster.hpp>
+
+
+#define PNETCDF_CHECK(call)						\
+    {									\
+	int status = (call);						\
+	if (status != NC_NOERR)						\
+	{								\
+	    std::cout << "PnetCDF error: " << ncmpi_strerror(status) << std::endl; \
+	    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);			\
+	}								\
+    }
+
+
+// Deterministic roughness in [-0.5, 0.5) depending only on the cell,
+// so the result does not depend on the number of ranks
+float roughness(std::uint64_t x, std::uint64_t y)
+{
+    std::uint64_t h = x * 0x9E3779B97F4A7C15ULL ^ (y + 0x632BE59BD9B4E019ULL) * 0xC2B2AE3D27D4EB4FULL;
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+    return static_cast<float>(h >> 40) / static_cast<float>(1 << 24) - 0.5f;
+}
+
+
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (argc < 4)
+    {
+	if (rank == 0)
+	{
+	    std::cout << "Usage: " << argv[0] << " <nx> <ny> <output.nc> [relief (m)] [tilt (m)]" << std::endl;
+	}
+	MPI_Finalize();
+	return EXIT_FAILURE;
+    }
+
+    const MPI_Offset nx = atol(argv[1]);
+    const MPI_Offset ny = atol(argv[2]);
+    const std::string fileName = argv[3];
+    const float relief = (argc > 4) ? atof(argv[4]) : 100.0;
+    const float tilt = (argc > 5) ? atof(argv[5]) : relief;
+
+    // Size of the fractal base surface: a power of 2 no bigger than the
+    // DEM itself and at most 1024
+    int order = 1;
+    while (order < 10 && (MPI_Offset(1) << (order + 1)) <= std::max(nx, ny))
+    {
+	order++;
+    }
+    const int baseSize = 1 << order;
+
+    std::vector<float> base(baseSize * baseSize);
+    if (rank == 0)
+    {
+	std::cout << "Generating " << nx << " x " << ny << " DEM on " << size << " ranks, fractal base surface "
+		  << baseSize << " x " << baseSize << std::endl;
+
+	Array2D<float> zeros(baseSize, baseSize, 0.0);
+	LSDRaster templateRaster(baseSize, baseSize, 0.0f, 0.0f, 1.0f, -9999.0f, zeros);
+	LSDRaster surface = templateRaster.DiamondSquare(order, relief);
+
+	float minimum = surface.get_data_element(0, 0);
+	for (int row = 0; row < baseSize; row++)
+	{
+	    for (int col = 0; col < baseSize; col++)
+	    {
+		minimum = std::min(minimum, surface.get_data_element(row, col));
+	    }
+	}
+	for (int row = 0; row < baseSize; row++)
+	{
+	    for (int col = 0; col < baseSize; col++)
+	    {
+		base[row * baseSize + col] = surface.get_data_element(row, col) - minimum;
+	    }
+	}
+    }
+    MPI_Bcast(base.data(), baseSize * baseSize, MPI_FLOAT, 0, MPI_COMM_WORLD);
+
+    // Block of rows of this rank
+    MPI_Offset firstRow = (ny * rank) / size;
+    MPI_Offset rows = (ny * (rank + 1)) / size - firstRow;
+
+    std::vector<float> elevation(rows * nx);
+    const double scaleX = (nx > 1) ? double(baseSize - 1) / (nx - 1) : 0.0;
+    const double scaleY = (ny > 1) ? double(baseSize - 1) / (ny - 1) : 0.0;
+    for (MPI_Offset j = 0; j < rows; j++)
+    {
+	MPI_Offset y = firstRow + j;
+	double by = y * scaleY;
+	int y0 = std::min(static_cast<int>(by), baseSize - 2);
+	double fy = by - y0;
+
+	for (MPI_Offset x = 0; x < nx; x++)
+	{
+	    double bx = x * scaleX;
+	    int x0 = std::min(static_cast<int>(bx), baseSize - 2);
+	    double fx = bx - x0;
+
+	    double z = (1 - fy) * ((1 - fx) * base[y0 * baseSize + x0] + fx * base[y0 * baseSize + x0 + 1])
+		+ fy * ((1 - fx) * base[(y0 + 1) * baseSize + x0] + fx * base[(y0 + 1) * baseSize + x0 + 1]);
+	    z += tilt * double(y) / ny;
+	    z += 0.001 * relief * roughness(x, y);
+
+	    elevation[j * nx + x] = static_cast<float>(z);
+	}
+    }
+
+    // Collective write, each rank its own rows
+    int ncid, dimids[2], varid;
+    PNETCDF_CHECK(ncmpi_create(MPI_COMM_WORLD, fileName.c_str(), NC_CLOBBER | NC_64BIT_DATA, MPI_INFO_NULL, &ncid));
+    PNETCDF_CHECK(ncmpi_def_dim(ncid, "y", ny, &dimids[0]));
+    PNETCDF_CHECK(ncmpi_def_dim(ncid, "x", nx, &dimids[1]));
+    PNETCDF_CHECK(ncmpi_def_var(ncid, "Band1", NC_FLOAT, 2, dimids, &varid));
+    const std::string longName = "synthetic DEM (demgen)";
+    PNETCDF_CHECK(ncmpi_put_att_text(ncid, varid, "long_name", longName.size(), longName.c_str()));
+    PNETCDF_CHECK(ncmpi_enddef(ncid));
+
+    MPI_Offset start[2] = { firstRow, 0 };
+    MPI_Offset count[2] = { rows, nx };
+    PNETCDF_CHECK(ncmpi_put_vara_float_all(ncid, varid, start, count, elevation.data()));
+    PNETCDF_CHECK(ncmpi_close(ncid));
+
+    if (rank == 0)
+    {
+	std::cout << "Written " << fileName << std::endl;
+    }
+
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,77 @@
+#!/bin/bash
+#
+# Weak and strong scaling runs of bin/hc on synthetic DEMs made by
+# bin/demgen. Each run writes a performance summary (see
+# performance_report_file) which scaling_report.py turns into a table
+# of parallel efficiency per simulator.
+#
+# Usage: tools/scaling/scaling.sh <weak|strong> <simulator> <size> "<ranks...>" [iterations] [output dir]
+#
+#   strong: the DEM is size x size cells for every number of ranks
+#   weak:   the DEM is size x size cells per rank (side scaled by sqrt(ranks))
+#
+# e.g.  tools/scaling/scaling.sh strong hipar 4096 "1 2 4 8 16"
+#       tools/scaling/scaling.sh weak striping 1024 "1 4 16 64"
+#       python3 tools/scaling/scaling_report.py scaling/
+#
+# MPIRUN can be set to the launcher of the machine (default mpirun -np).
+
+set -e
+
+mode=$1
+simulator=$2
+size=$3
+ranks_list=$4
+iterations=${5:-100}
+output_dir=${6:-scaling}
+mpirun=${MPIRUN:-"mpirun -np"}
+
+if [ "$mode" != "weak" ] && [ "$mode" != "strong" ] || [ -z "$ranks_list" ]
+then
+    head -n 20 "$0" | tail -n +2
+    exit 1
+fi
+
+bin_dir=$(cd "$(dirname "$0")/../../bin" && pwd)
+mkdir -p "$output_dir"
+cd "$output_dir"
+
+for ranks in $ranks_list
+do
+    if [ "$mode" = "strong" ]
+    then
+	side=$size
+    else
+	side=$(awk -v s="$size" -v p="$ranks" 'BEGIN { printf "%d", s * sqrt(p) + 0.5 }')
+    fi
+
+    dem="dem_${side}.nc"
+    if [ ! -f "$dem" ]
+    then
+	$mpirun "$ranks" "$bin_dir/demgen" "$side" "$side" "$dem"
+    fi
+
+    run="${mode}_${simulator}_${ranks}"
+    cat > "$run.params" <<PARAMS
+input_dem_netcdf_file:		$dem
+input_dem_netcdf_variable:	Band1
+DX:				10
+DY:				10
+slope_on_edge_cell:		0.001
+courant_number:			0.7
+froude_num_limit:		0.8
+mannings_n:			0.04
+hflow_threshold:		0.001
+water_depth_erosion_threshold:	0.01
+rain_above_elevation:		0.0
+rain_rate:			10.0
+simulator:			$simulator
+no_of_iterations:		$iterations
+timestep:			1
+progress_interval:		$iterations
+performance_report_file:	$run
+PARAMS
+
+    echo "=== $mode scaling, $simulator, $ranks ranks, ${side} x ${side} cells"
+    $mpirun "$ranks" "$bin_dir/hc" "$run.params" > "$run.log"
+done
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+"""
+Parallel efficiency from the performance summaries written by
+tools/scaling/scaling.sh (<weak|strong>_<simulator>_<ranks>.json).
+
+Usage: scaling_report.py [directory] [csv file]
+
+For each mode and simulator, efficiency is relative to the run on the
+fewest ranks (p0, wall time t0):
+    strong: E(p) = (t0 * p0) / (t(p) * p)
+    weak:   E(p) = t0 / t(p)
+"""
+
+import csv
+import glob
+import json
+import os
+import sys
+
+
+def main():
+    directory = sys.argv[1] if len(sys.argv) > 1 else "scaling"
+    csv_file = sys.argv[2] if len(sys.argv) > 2 else os.path.join(directory, "scaling_report.csv")
+
+    runs = {}
+    for path in glob.glob(os.path.join(directory, "*_*_*.json")):
+        mode, simulator, _ = os.path.basename(path)[:-len(".json")].split("_", 2)
+        with open(path) as f:
+            summary = json.load(f)
+        runs.setdefault((mode, simulator), []).append(summary)
+
+    rows = []
+    for (mode, simulator), summaries in sorted(runs.items()):
+        summaries.sort(key=lambda s: s["ranks"])
+        p0, t0 = summaries[0]["ranks"], summaries[0]["wall_time"]
+
+        print("\n%s scaling, %s simulator" % (mode, simulator))
+        print("%8s %12s %12s %14s %10s %10s" % ("ranks", "cells", "wall time", "cells/s", "speedup", "efficiency"))
+        for s in summaries:
+            p, t = s["ranks"], s["wall_time"]
+            if mode == "strong":
+                speedup = t0 / t
+                efficiency = (t0 * p0) / (t * p)
+            else:
+                speedup = (t0 / t) * (p / p0)
+                efficiency = t0 / t
+            print("%8d %12d %12.3f %14.4g %10.2f %10.3f"
+                  % (p, s["cells"], t, s["cell_updates_per_second"], speedup, efficiency))
+            rows.append([mode, simulator, p, s["cells"], t, s["cell_updates_per_second"],
+                         speedup, efficiency, s["compute"]["imbalance"]])
+
+    with open(csv_file, "w") as f:
+        writer = csv.writer(f)
+        writer.writerow(["mode", "simulator", "ranks", "cells", "wall_time", "cell_updates_per_second",
+                         "speedup", "efficiency", "compute_imbalance"])
+        writer.writerows(rows)
+    print("\nWritten " + csv_file)
+
+
+if __name__ == "__main__":
+    main()